@@ -0,0 +1,30 @@
+;; Per-call cost of the native bindings inside tight dotimes loops.
+;; From the REPL: (load "bench.scm")
+
+(define bench-iterations 2000000)
+
+;; the best of five runs of (dotimes (i bench-iterations) expr) in a
+;; function body, where the optimizer sees it
+(define-macro (bench name expr)
+  `(let ((loop (lambda ()
+                 (dotimes (i bench-iterations)
+                   ,expr)))
+         (best 1e10))
+     (dotimes (run 5)
+       (let ((start (*s7* 'cpu-time)))
+         (loop)
+         (set! best (min best (- (*s7* 'cpu-time) start)))))
+     (format #t "~A: ~,3F s, ~,1F ns per call~%" ,name best (/ (* best 1e9) bench-iterations))))
+
+(define bench-a (vec2 1.0 2.0))
+(define bench-b (vec2 3.0 4.0))
+(define bench-t 0.25)
+
+(bench "empty loop" #f)
+(bench "ease-cubic-in-out" (ease-cubic-in-out bench-t))
+(bench "rnd" (rnd 0.0 10.0))
+(bench "vec2" (vec2 bench-t bench-t))
+(bench "vec2+" (vec2+ bench-a bench-b))
+(bench "vec2*" (vec2* bench-a bench-t))
+(bench "vec2-x" (vec2-x bench-a))
+(bench "vec2?" (vec2? bench-a))
@@ -0,0 +1,205 @@
+// -*- c++ -*-
+// Timing for PoolAllocator against VectorPool, the pool it replaced,
+// which kept free slots as a std::vector of pointers. Vec2 objects, grow
+// 16384, best of 5 runs. "alloc" and "free" free all live objects in
+// random order before allocating them again, the worst case for a free
+// list; "+ work" is that allocation again with about 50 ns spent on each
+// object, as a caller would; "sorted" calls sort_free_list() between the
+// frees and the allocations, and "sort" is the sort's own time.
+#include "../misc.h"
+#include <stdio.h>
+#include <chrono>
+
+// the pool before free slots held the free-list link
+template <typename T>
+class VectorPool
+{
+  void resize()
+  {
+    T* m = new T[grow];
+    mem.push_back(m);
+    u32 plen = pool.size();
+    pool.resize(pool.size() + grow);
+    for (u32 i = 0; i < grow; i++) {
+      pool[plen + i] = m + i;
+    }
+  }
+
+  u32 grow;
+  std::vector<T*> pool;    // free objects
+  std::vector<T*> mem;     // blocks of grow objects
+
+public:
+  VectorPool(u32 _grow) : grow(_grow) {}
+
+  ~VectorPool()
+  {
+    for (const auto& p : mem) {
+      delete [] p;
+    }
+  }
+
+  inline T* allocate()
+  {
+    if (pool.empty()) {
+      resize();
+    }
+    T* v = pool.back();
+    pool.pop_back();
+    return v;
+  }
+
+  void clear()
+  {
+    pool.clear();
+    for (auto m : mem) {
+      for (u32 i = 0; i < grow; i++) {
+        pool.push_back(m + i);
+      }
+    }
+  }
+
+  inline void free(T* p)
+  {
+    pool.push_back(p);
+  }
+
+  void sort_free_list() {}
+};
+
+static const u32 GROW = 16384;
+static const u32 ROUNDS = 20;
+
+typedef std::chrono::steady_clock Clock;
+
+static f64 ns_since(Clock::time_point start)
+{
+  return std::chrono::duration<f64, std::nano>(Clock::now() - start).count();
+}
+
+// a dependent chain the allocation's cache miss can overlap with
+static inline f32 work(f32 x)
+{
+  for (u32 i = 0; i < 16; i++) {
+    x = x * 0.999f + 0.5f;
+  }
+  return x;
+}
+
+struct Times
+{
+  f64 alloc = 1e30, free = 1e30, sort = 1e30;
+};
+
+// ns per object, over ROUNDS rounds of n allocations and n frees
+template <typename P>
+static Times scrambled(u32 n, bool with_work, bool sorted)
+{
+  Times best;
+  std::vector<Vec2*> live(n);
+  for (u32 run = 0; run < 5; run++) {
+    P pool(GROW);
+    Rng rng = Rng::seeded(run);
+    f64 a = 0, f = 0, s = 0;
+    f32 x = 1;
+    for (u32 round = 0; round < ROUNDS; round++) {
+      Clock::time_point start = Clock::now();
+      if (with_work) {
+        for (Vec2*& p : live) {
+          p = pool.allocate();
+          x = work(x);
+          p->x = x;
+        }
+      } else {
+        for (Vec2*& p : live) {
+          p = pool.allocate();
+          p->x = 1;
+        }
+      }
+      a += ns_since(start);
+      for (u32 i = n - 1; i > 0; i--) {
+        std::swap(live[i], live[rng.next() % (i + 1)]);
+      }
+      start = Clock::now();
+      for (Vec2* p : live) {
+        x += p->x;
+        pool.free(p);
+      }
+      f += ns_since(start);
+      if (sorted) {
+        start = Clock::now();
+        pool.sort_free_list();
+        s += ns_since(start);
+      }
+    }
+    asm volatile("" : : "r"(x));
+    best.alloc = std::min(best.alloc, a / (f64(ROUNDS) * n));
+    best.free = std::min(best.free, f / (f64(ROUNDS) * n));
+    best.sort = std::min(best.sort, s / (f64(ROUNDS) * n));
+  }
+  return best;
+}
+
+// 1000 objects allocated and freed in stack order, 20M times in all
+template <typename P>
+static f64 lifo()
+{
+  f64 best = 1e30;
+  for (u32 run = 0; run < 5; run++) {
+    P pool(GROW);
+    Vec2* tmp[1000];
+    const Clock::time_point start = Clock::now();
+    for (u32 round = 0; round < 20000; round++) {
+      for (u32 i = 0; i < 1000; i++) {
+        tmp[i] = pool.allocate();
+        tmp[i]->x = i;
+      }
+      for (u32 i = 1000; i-- > 0;) {
+        pool.free(tmp[i]);
+      }
+    }
+    best = std::min(best, ns_since(start) / 20e6);
+  }
+  return best;
+}
+
+// n allocations, then clear()
+template <typename P>
+static f64 clear(u32 n)
+{
+  f64 best = 1e30;
+  for (u32 run = 0; run < 5; run++) {
+    P pool(GROW);
+    const Clock::time_point start = Clock::now();
+    for (u32 round = 0; round < ROUNDS; round++) {
+      for (u32 i = 0; i < n; i++) {
+        pool.allocate()->x = 1;
+      }
+      pool.clear();
+    }
+    best = std::min(best, ns_since(start) / (f64(ROUNDS) * n));
+  }
+  return best;
+}
+
+template <typename P>
+static void row(const char* name, u32 n)
+{
+  const Times plain = scrambled<P>(n, false, false);
+  const Times worked = scrambled<P>(n, true, false);
+  const Times sorted = scrambled<P>(n, false, true);
+  printf("%-14s %8u %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f\n", name, n, plain.alloc, plain.free, worked.alloc,
+         sorted.alloc, sorted.sort, lifo<P>(), clear<P>(n));
+}
+
+int main()
+{
+  printf("%-14s %8s %7s %7s %7s %7s %7s %7s %7s\n", "ns per object", "live", "alloc", "free", "+ work", "sorted",
+         "sort", "lifo", "clear");
+  const u32 sizes[] = {1000, 100000, 1000000};
+  for (u32 n : sizes) {
+    row<VectorPool<Vec2>>("VectorPool", n);
+    row<PoolAllocator<Vec2>>("PoolAllocator", n);
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+// -*- c++ -*-
+// Uniformity check for Rng::below(), which rng-integer draws from. For
+// each n the results are counted into buckets, and every bucket has to
+// come within 6 standard deviations of an even share. n = 1.5 * 2^30 is
+// the case plain multiply-shift gets wrong: results k with k % 3 == 2
+// have two of the 2^32 draws behind them, the rest three. Bucketing by
+// k % 3 shows that, and the plain form is run through the same test to
+// show the check can see it. Exits nonzero on failure.
+#include "../misc.h"
+#include <stdio.h>
+
+static const u32 DRAWS = 6000000;
+
+// bucket of result k, of buckets
+typedef u32 (*Bucket)(u32 k, u32 n);
+
+static u32 by_value(u32 k, u32)
+{
+  return k;
+}
+
+static u32 by_mod3(u32 k, u32)
+{
+  return k % 3;
+}
+
+static u32 by_range(u32 k, u32 n)
+{
+  return u32(u64(k) * 16 / n);
+}
+
+static u32 plain(Rng& r, u32 n)
+{
+  return u32((u64(r.next()) * n) >> 32);
+}
+
+static u32 below(Rng& r, u32 n)
+{
+  return r.below(n);
+}
+
+// largest deviation from an even share, in standard deviations
+static f64 worst_deviation(u32 (*draw)(Rng&, u32), u32 n, Bucket bucket, u32 buckets)
+{
+  std::vector<u64> counts(buckets, 0);
+  Rng r = Rng::seeded(n);
+  for (u32 i = 0; i < DRAWS; i++) {
+    const u32 k = draw(r, n);
+    if (k >= n) {
+      return 1e30;
+    }
+    counts[bucket(k, n)]++;
+  }
+  const f64 p = 1.0 / buckets, expected = DRAWS * p, sigma = sqrt(DRAWS * p * (1 - p));
+  f64 worst = 0;
+  for (u64 c : counts) {
+    worst = std::max(worst, fabs(f64(c) - expected) / sigma);
+  }
+  return worst;
+}
+
+int main()
+{
+  struct Case
+  {
+    u32 n;
+    Bucket bucket;
+    u32 buckets;
+    const char* by;
+  };
+  const Case cases[] = {
+    {1, by_value, 1, "value"},
+    {2, by_value, 2, "value"},
+    {7, by_value, 7, "value"},
+    {1000, by_value, 1000, "value"},
+    {1610612736, by_mod3, 3, "k % 3"},    // 1.5 * 2^30
+    {1610612736, by_range, 16, "16ths"},
+    {2147483647, by_range, 16, "16ths"},
+    {3221225472u, by_mod3, 3, "k % 3"},    // 1.5 * 2^31
+  };
+  bool ok = true;
+  printf("%-12s %-6s %12s\n", "n", "by", "worst sigma");
+  for (const Case& c : cases) {
+    const f64 d = worst_deviation(below, c.n, c.bucket, c.buckets);
+    ok &= d < 6;
+    printf("%-12u %-6s %12.2f %s\n", c.n, c.by, d, d < 6 ? "ok" : "FAILED");
+  }
+
+  const f64 d = worst_deviation(plain, 1610612736, by_mod3, 3);
+  printf("\nwithout rejection, n = 1610612736 by k %% 3: %.0f sigma (must fail)\n", d);
+  ok &= d >= 6;
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+// -*- c++ -*-
+// Timing for the fast trig in simd.h and misc.h against libm: ns per
+// element over a 4096 element array, best of 5 runs. Angles are within
+// +-100 unless the name says far, where a quarter of them are past
+// FAST_TRIG_RANGE and go the libm way.
+#include "../simd.h"
+#include <stdio.h>
+#include <chrono>
+
+static const u32 N = 4096;
+static const u32 REPEATS = 500;
+
+static f32 in[N], in_far[N], out0[N], out1[N];
+
+template <typename F>
+static void time(const char* name, F f)
+{
+  f64 best = 1e9;
+  for (u32 run = 0; run < 5; run++) {
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 r = 0; r < REPEATS; r++) {
+      f();
+      asm volatile("" : : : "memory");    // so repeats are not folded
+    }
+    const f64 ns = std::chrono::duration<f64, std::nano>(std::chrono::steady_clock::now() - start).count();
+    best = std::min(best, ns / (f64(REPEATS) * N));
+  }
+  printf("%-26s %6.2f ns\n", name, best);
+}
+
+static void fast_sincos_wide(const f32* as)
+{
+  for (u32 i = 0; i < N; i += Wide::width) {
+    F32x<Wide> s, c;
+    fast_sincos(F32x<Wide>::load(as + i), s, c);
+    s.store(out0 + i);
+    c.store(out1 + i);
+  }
+}
+
+int main()
+{
+  Rng rng = Rng::seeded(1);
+  for (u32 i = 0; i < N; i++) {
+    in[i] = (rng.next01() * 2 - 1) * 100;
+    in_far[i] = i % 4 ? in[i] : in[i] * 1000;
+  }
+
+  printf("%s lanes\n\n", Wide::width == 8 ? "avx" : Wide::width == 4 ? "sse" : "scalar");
+  time("sinf + cosf", [] {
+    for (u32 i = 0; i < N; i++) {
+      out0[i] = sinf(in[i]);
+      out1[i] = cosf(in[i]);
+    }
+  });
+  time("fast_sincos", [] {
+    for (u32 i = 0; i < N; i++) {
+      fast_sincos(in[i], out0 + i, out1 + i);
+    }
+  });
+  time("fast_sincos wide", [] { fast_sincos_wide(in); });
+  time("fast_sincos wide, far", [] { fast_sincos_wide(in_far); });
+  time("atan2f", [] {
+    for (u32 i = 0; i < N; i++) {
+      out0[i] = atan2f(in[i], in[(i + 7) % N]);
+    }
+  });
+  time("fast_atan2", [] {
+    for (u32 i = 0; i < N; i++) {
+      out0[i] = fast_atan2(in[i], in[(i + 7) % N]);
+    }
+  });
+  time("fast_atan2 wide", [] {
+    for (u32 i = 0; i < N; i += Wide::width) {
+      fast_atan2(F32x<Wide>::load(in + i), F32x<Wide>::load(in + (i + 8) % N)).store(out0 + i);
+    }
+  });
+  time("atan2f(sinf, cosf)", [] {
+    for (u32 i = 0; i < N; i++) {
+      out0[i] = atan2f(sinf(in[i]), cosf(in[i]));
+    }
+  });
+  time("wrap_angle", [] {
+    for (u32 i = 0; i < N; i++) {
+      out0[i] = wrap_angle(in[i]);
+    }
+  });
+  time("wrap_angle wide", [] {
+    for (u32 i = 0; i < N; i += Wide::width) {
+      wrap_angle(F32x<Wide>::load(in + i)).store(out0 + i);
+    }
+  });
+  time("wrap_angle wide, far", [] {
+    for (u32 i = 0; i < N; i += Wide::width) {
+      wrap_angle(F32x<Wide>::load(in_far + i)).store(out0 + i);
+    }
+  });
+  time("angles_diff", [] {
+    for (u32 i = 0; i < N; i++) {
+      out0[i] = angles_diff(in[(i + 7) % N], in[i]);
+    }
+  });
+  time("angles_lerp", [] {
+    for (u32 i = 0; i < N; i++) {
+      out0[i] = angles_lerp(in[i], in[(i + 7) % N], 0.3f);
+    }
+  });
+  time("rotate", [] {
+    for (u32 i = 0; i < N; i++) {
+      const Vec2 v = rotate(vec2(1, 2), in[i]);
+      out0[i] = v.x;
+      out1[i] = v.y;
+    }
+  });
+  return 0;
+}
@@ -0,0 +1,348 @@
+// -*- c++ -*-
+// Accuracy check for the fast trig in simd.h and misc.h: sweeps the
+// finite f32 range with a stride, plus special values, and measures the
+// max abs and ulp error against double precision, with libm sinf(),
+// cosf() and atan2f() alongside for scale. Exits nonzero when an error
+// goes past its bound (the ones documented in simd.h), when a lane-wise
+// form differs from its scalar form, or when the rotation helpers
+// disagree with sin_cos(). Built twice by build.ninja, the second time
+// with FAST_TRIG=1. The identities hold as long as the compiler does not
+// contract into FMAs differently per file: with -mfma, add
+// -ffp-contract=off.
+#include "../simd.h"
+#include "../vec2_buffer.h"
+#include <stdio.h>
+#include <string.h>
+
+static const u32 STRIDE = 97;           // of the bit patterns swept
+static const u32 CHUNK = 4096;
+static const u32 ATAN2_SAMPLES = 1 << 24;
+
+static f32 from_bits(u32 b)
+{
+  f32 a;
+  memcpy(&a, &b, sizeof a);
+  return a;
+}
+
+static u32 to_bits(f32 a)
+{
+  u32 b;
+  memcpy(&b, &a, sizeof b);
+  return b;
+}
+
+static bool same(f32 a, f32 b)
+{
+  return to_bits(a) == to_bits(b) || (a != a && b != b);
+}
+
+// of the f32 nearest to x
+static f64 ulp(f64 x)
+{
+  x = fabs(x);
+  if (x < FLT_MIN) {
+    return ldexp(1.0, -149);
+  }
+  int e;
+  frexp(x, &e);
+  return ldexp(1.0, e - 24);
+}
+
+struct Error
+{
+  const char* name;
+  f64 abs_bound;    // 0 when unchecked, as for libm
+  f64 ulp_bound;    // also unchecked for the fast sine and cosine, which
+                    // are accurate in abs, not relative, terms next to
+                    // their zeros
+  f64 max_abs;
+  f64 max_ulp;
+  f32 worst_abs[2];
+  f32 worst_ulp[2];
+  u32 nan_mismatches;
+
+  Error(const char* name, f64 abs_bound, f64 ulp_bound)
+    : name(name), abs_bound(abs_bound), ulp_bound(ulp_bound), max_abs(0), max_ulp(0), nan_mismatches(0)
+  {
+    worst_abs[0] = worst_abs[1] = worst_ulp[0] = worst_ulp[1] = 0;
+  }
+
+  void add(f64 got, f64 want, f32 in0, f32 in1 = 0)
+  {
+    if (want != want || got != got) {
+      nan_mismatches += (want != want) != (got != got);
+      return;
+    }
+    const f64 e = fabs(got - want);
+    if (e > max_abs) {
+      max_abs = e;
+      worst_abs[0] = in0;
+      worst_abs[1] = in1;
+    }
+    const f64 u = e / ulp(want);
+    if (u > max_ulp) {
+      max_ulp = u;
+      worst_ulp[0] = in0;
+      worst_ulp[1] = in1;
+    }
+  }
+
+  bool report() const
+  {
+    const bool ok = (abs_bound == 0 || max_abs <= abs_bound) && (ulp_bound == 0 || max_ulp <= ulp_bound) &&
+                    nan_mismatches == 0;
+    char ab[16] = "-", ub[16] = "-";
+    if (abs_bound) {
+      snprintf(ab, sizeof ab, "%.3g", abs_bound);
+    }
+    if (ulp_bound) {
+      snprintf(ub, sizeof ub, "%.4g", ulp_bound);
+    }
+    printf("%-12s %9.3g %9s %9.4g %7s  %-15.9g %-15.9g %-15.9g %-15.9g %s\n", name, max_abs, ab, max_ulp, ub,
+           worst_abs[0], worst_abs[1], worst_ulp[0], worst_ulp[1], ok ? "ok" : "FAILED");
+    if (nan_mismatches) {
+      printf("%-12s %u NaN mismatches\n", "", nan_mismatches);
+    }
+    return ok;
+  }
+};
+
+static Error fast_sin("fast_sin", 9.2e-8, 0);
+static Error fast_cos("fast_cos", 9.2e-8, 0);
+static Error libm_sin("sinf", 0, 0);
+static Error libm_cos("cosf", 0, 0);
+static Error fast_atan("fast_atan2", 2.8e-7, 4.0);
+static Error libm_atan("atan2f", 0, 0);
+static Error wrap("wrap_angle", 1.2e-7, 0);
+static Error wrap_range("past PI", 1e-7, 0);    // over |a|
+static u32 lane_mismatches = 0;
+static u32 rotation_mismatches = 0;
+
+template <typename L>
+static void lanes_sincos(const f32* as, f32* ss, f32* cs, u32 n)
+{
+  for (u32 i = 0; i < n; i += L::width) {
+    F32x<L> s, c;
+    fast_sincos(F32x<L>::load(as + i), s, c);
+    s.store(ss + i);
+    c.store(cs + i);
+  }
+}
+
+template <typename L>
+static void lanes_atan2(const f32* ys, const f32* xs, f32* out, u32 n)
+{
+  for (u32 i = 0; i < n; i += L::width) {
+    fast_atan2(F32x<L>::load(ys + i), F32x<L>::load(xs + i)).store(out + i);
+  }
+}
+
+template <typename L>
+static void lanes_wrap(const f32* as, f32* out, u32 n)
+{
+  for (u32 i = 0; i < n; i += L::width) {
+    wrap_angle(F32x<L>::load(as + i)).store(out + i);
+  }
+}
+
+static void check_sincos(const f32* as, u32 n)
+{
+  f32 ws[CHUNK], wc[CHUNK], ls[CHUNK], lc[CHUNK];
+  lanes_sincos<Wide>(as, ws, wc, n);
+  lanes_sincos<Scalar>(as, ls, lc, n);
+  for (u32 i = 0; i < n; i++) {
+    const f32 a = as[i];
+    f32 s, c;
+    fast_sincos(a, &s, &c);
+    lane_mismatches += !same(s, ws[i]) || !same(c, wc[i]) || !same(s, ls[i]) || !same(c, lc[i]);
+    const f64 want_s = sin(f64(a)), want_c = cos(f64(a));
+    fast_sin.add(s, want_s, a);
+    fast_cos.add(c, want_c, a);
+    libm_sin.add(sinf(a), want_s, a);
+    libm_cos.add(cosf(a), want_c, a);
+  }
+}
+
+static void check_atan2(const f32* ys, const f32* xs, u32 n)
+{
+  f32 wt[CHUNK], lt[CHUNK];
+  lanes_atan2<Wide>(ys, xs, wt, n);
+  lanes_atan2<Scalar>(ys, xs, lt, n);
+  for (u32 i = 0; i < n; i++) {
+    const f32 y = ys[i], x = xs[i];
+    const f32 t = fast_atan2(y, x);
+    lane_mismatches += !same(t, wt[i]) || !same(t, lt[i]);
+    if (y == 0) {
+      // documented: 0 at the origin, PI for either zero with x < 0
+      fast_atan.nan_mismatches += !same(t, x < 0 ? PI : 0.0f);
+    } else {
+      fast_atan.add(t, atan2(f64(y), f64(x)), y, x);
+    }
+    libm_atan.add(atan2f(y, x), atan2(f64(y), f64(x)), y, x);
+  }
+}
+
+static void check_wrap(const f32* as, u32 n)
+{
+  f32 ww[CHUNK], lw[CHUNK];
+  lanes_wrap<Wide>(as, ww, n);
+  lanes_wrap<Scalar>(as, lw, n);
+  for (u32 i = 0; i < n; i++) {
+    const f32 a = as[i];
+    const f32 w = wrap_angle(a);
+    lane_mismatches += !same(w, ww[i]) || !same(w, lw[i]);
+    // the double reduction is exact for any f32, unlike a - 2 PI k
+    const f64 want = atan2(sin(f64(a)), cos(f64(a)));
+    if (a == a && fabsf(a) <= FLT_MAX) {
+      wrap.add(want + remainder(f64(w) - want, 2 * M_PI), want, a);
+      wrap_range.add(std::max(fabsf(w) - f64(PI), 0.0) / std::max(fabsf(a), 1.0f), 0, a);
+    } else {
+      wrap.nan_mismatches += w == w;
+    }
+  }
+}
+
+// rotate(), xunit_rotated(), yunit_rotated(), mat2x3_rotation() and the
+// vec2-buffer rotation all take sin and cos from sin_cos(); with misc.cc
+// and vec2_buffer.cc built with this file's FAST_TRIG they match it
+static void check_rotations(f32 a)
+{
+  f32 s, c;
+  sin_cos(a, &s, &c);
+#if FAST_TRIG
+  f32 fs, fc;
+  fast_sincos(a, &fs, &fc);
+  rotation_mismatches += !same(s, fs) || !same(c, fc);
+#else
+  rotation_mismatches += !same(s, sinf(a)) || !same(c, cosf(a));
+#endif
+  const Vec2 v = vec2(3, -2);
+  const Vec2 r = rotate(v, a);
+  rotation_mismatches += !same(r.x, v.x * c - v.y * s) || !same(r.y, v.y * c + v.x * s);
+  const Vec2 xu = xunit_rotated(a), yu = yunit_rotated(a);
+  rotation_mismatches += !same(xu.x, c) || !same(xu.y, s) || !same(yu.x, -s) || !same(yu.y, c);
+  const Mat2x3 m = mat2x3_rotation(a);
+  rotation_mismatches += !same(m.a, c) || !same(m.b, s) || !same(m.c, -s) || !same(m.d, c);
+
+  Vec2Buffer b(Wide::width + 1);    // through both kernels
+  fill(b, v);
+  rotate(b, a);
+  for (u32 i = 0; i < b.size(); i++) {
+    rotation_mismatches += !same(b.xs[i], r.x) || !same(b.ys[i], r.y);
+  }
+}
+
+// finite or not, and the neighbours of the values where the code changes
+// path
+static std::vector<f32> specials()
+{
+  std::vector<f32> v;
+  const f32 base[] = {0.0f, from_bits(1), FLT_MIN, 1e-30f, 1e-7f, 0.5f, 1.0f, HALF_PI, PI, TWO_PI,
+                      100.0f, 4096.0f, FAST_TRIG_RANGE, 4194304.0f, 8388608.0f, 16777216.0f,
+                      1e20f, 1e38f, FLT_MAX, INFINITY, NAN};
+  for (f32 x : base) {
+    for (f32 y : {nextafterf(x, 0), x, nextafterf(x, INFINITY)}) {
+      v.push_back(y);
+      v.push_back(-y);
+    }
+  }
+  return v;
+}
+
+static void sweep_angles()
+{
+  f32 as[CHUNK];
+  u32 n = 0;
+  const std::vector<f32> sp = specials();
+  for (f32 a : sp) {
+    as[n++] = a;
+  }
+  for (u64 b = 0; b < 0x7f800000; b += STRIDE) {
+    as[n++] = from_bits(u32(b));
+    as[n++] = -from_bits(u32(b));
+    if (n == CHUNK) {
+      check_sincos(as, n);
+      check_wrap(as, n);
+      n = 0;
+    }
+  }
+  for (u32 i = n; i % Wide::width; i++) {
+    as[i] = 0;
+  }
+  check_sincos(as, n);
+  check_wrap(as, n);
+
+  for (f32 a : sp) {
+    check_rotations(a);
+  }
+  for (u64 b = 0; b < 0x7f800000; b += STRIDE * 1000) {
+    check_rotations(from_bits(u32(b)));
+    check_rotations(-from_bits(u32(b)));
+  }
+}
+
+static void sweep_atan2()
+{
+  f32 ys[CHUNK] = {}, xs[CHUNK] = {};
+  u32 n = 0;
+  const std::vector<f32> sp = specials();
+  for (f32 y : sp) {
+    for (f32 x : sp) {
+      if (fabsf(y) <= FLT_MAX && fabsf(x) <= FLT_MAX) {
+        ys[n] = y;
+        xs[n++] = x;
+        if (n == CHUNK) {
+          check_atan2(ys, xs, n);
+          n = 0;
+        }
+      }
+    }
+  }
+  for (u32 i = n; i % Wide::width; i++) {
+    ys[i] = xs[i] = 0;
+  }
+  check_atan2(ys, xs, n);
+
+  // half uniform over the bit patterns, which covers every ratio of
+  // magnitudes, and half on circles of every magnitude, which covers
+  // every angle
+  Rng rng = Rng::seeded(1);
+  for (u32 i = 0; i < ATAN2_SAMPLES; i += CHUNK) {
+    for (u32 j = 0; j < CHUNK; j++) {
+      if (j & 1) {
+        ys[j] = from_bits(rng.next() % 0x7f800000 | (rng.next() & 0x80000000));
+        xs[j] = from_bits(rng.next() % 0x7f800000 | (rng.next() & 0x80000000));
+      } else {
+        const f64 m = ldexp(1.0 + rng.next() / 4294967296.0, i32(rng.next() % 254) - 126) * 0.999;
+        const f64 t = (rng.next() / 4294967296.0 * 2 - 1) * M_PI;
+        ys[j] = f32(m * sin(t));
+        xs[j] = f32(m * cos(t));
+      }
+    }
+    check_atan2(ys, xs, CHUNK);
+  }
+}
+
+int main()
+{
+  sweep_angles();
+  sweep_atan2();
+
+  printf("FAST_TRIG=%d, %s lanes\n\n", FAST_TRIG, Wide::width == 8 ? "avx" : Wide::width == 4 ? "sse" : "scalar");
+  printf("%-12s %9s %9s %9s %7s  %-31s %s\n", "", "max abs", "bound", "max ulp", "bound", "worst abs at", "worst ulp at");
+  bool ok = true;
+  ok &= fast_sin.report();
+  ok &= fast_cos.report();
+  ok &= libm_sin.report();
+  ok &= libm_cos.report();
+  ok &= fast_atan.report();
+  ok &= libm_atan.report();
+  ok &= wrap.report();
+  ok &= wrap_range.report();
+  printf("\nlane-wise forms differing from scalar: %u\n", lane_mismatches);
+  printf("rotations differing from sin_cos(): %u\n", rotation_mismatches);
+  ok &= lane_mismatches == 0 && rotation_mismatches == 0;
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
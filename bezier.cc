@@ -0,0 +1,94 @@
+// -*- c++ -*-
+#include "bezier.h"
+
+#include "simd.h"
+#include <algorithm>
+
+BezierCurve::BezierCurve(const Vec2& p0, const Vec2& p1, const Vec2& p2, const Vec2& p3)
+  : a(p3 - p0 + (p1 - p2) * 3),
+    b((p0 + p2) * 3 - p1 * 6),
+    c((p1 - p0) * 3),
+    d(p0),
+    lengths(SEGMENTS + 1)
+{
+  // sum of chords, short of the true length by about 1e-4 relative on
+  // ordinary curves
+  lengths[0] = 0;
+  Vec2 prev = p0;
+  for (u32 i = 1; i <= SEGMENTS; i++) {
+    const Vec2 p = position(f32(i) / SEGMENTS);
+    lengths[i] = lengths[i - 1] + distance(prev, p);
+    prev = p;
+  }
+}
+
+Vec2 BezierCurve::position(f32 t) const
+{
+  t = clamp01(t);
+  return ((a * t + b) * t + c) * t + d;
+}
+
+Vec2 BezierCurve::tangent(f32 t) const
+{
+  t = clamp01(t);
+  return normalized((a * (3 * t) + b * 2) * t + c);
+}
+
+f32 BezierCurve::t_at(f32 distance) const
+{
+  if (!(distance > 0)) {
+    return 0;
+  }
+  if (distance >= length()) {
+    return 1;
+  }
+  // lengths[i] <= distance < lengths[i + 1], linear in between
+  const u32 i = std::upper_bound(lengths.begin(), lengths.end(), distance) - lengths.begin() - 1;
+  const f32 span = lengths[i + 1] - lengths[i];
+  const f32 f = span > 0 ? (distance - lengths[i]) / span : 0;
+  return (i + f) / SEGMENTS;
+}
+
+template <typename L>
+static u32 positions_k(const BezierCurve& c, const f64* ts, u32 i, u32 n, f64* out)
+{
+  const Vec2x<L> a = Vec2x<L>::splat(c.a), b = Vec2x<L>::splat(c.b);
+  const Vec2x<L> vc = Vec2x<L>::splat(c.c), d = Vec2x<L>::splat(c.d);
+  for (; i + L::width <= n; i += L::width) {
+    const F32x<L> t = clamp01(F32x<L>::load(ts + i));
+    (((a * t + b) * t + vc) * t + d).store_pairs(out + 2 * i);
+  }
+  return i;
+}
+
+void positions(const BezierCurve& c, const f64* ts, u32 n, f64* out)
+{
+  u32 i = positions_k<Wide>(c, ts, 0, n, out);
+  positions_k<Scalar>(c, ts, i, n, out);
+}
+
+template <typename L>
+static u32 tangents_k(const BezierCurve& c, const f64* ts, u32 i, u32 n, f64* out)
+{
+  // p'(t) = (3a t + 2b) t + c
+  const Vec2x<L> a = Vec2x<L>::splat(c.a * 3), b = Vec2x<L>::splat(c.b * 2);
+  const Vec2x<L> vc = Vec2x<L>::splat(c.c);
+  for (; i + L::width <= n; i += L::width) {
+    const F32x<L> t = clamp01(F32x<L>::load(ts + i));
+    normalized((a * t + b) * t + vc).store_pairs(out + 2 * i);
+  }
+  return i;
+}
+
+void tangents(const BezierCurve& c, const f64* ts, u32 n, f64* out)
+{
+  u32 i = tangents_k<Wide>(c, ts, 0, n, out);
+  tangents_k<Scalar>(c, ts, i, n, out);
+}
+
+void ts_at(const BezierCurve& c, const f64* distances, u32 n, f64* out)
+{
+  for (u32 i = 0; i < n; i++) {
+    out[i] = c.t_at(distances[i]);
+  }
+}
@@ -0,0 +1,36 @@
+// -*- c++ -*-
+#pragma once
+
+#include "misc.h"
+
+// A cubic bezier prepared once for sampling many times: power basis
+// coefficients for evaluation, and a table of cumulative arc lengths for
+// moving along the curve at a constant speed.
+struct BezierCurve
+{
+  static const u32 SEGMENTS = 128;    // of the arc length table
+
+  Vec2 a, b, c, d;              // p(t) = ((a t + b) t + c) t + d
+  std::vector<f32> lengths;     // lengths[i]: arc length up to t = i / SEGMENTS
+
+  BezierCurve(const Vec2& p0, const Vec2& p1, const Vec2& p2, const Vec2& p3);
+
+  f32 length() const
+  {
+    return lengths.back();
+  }
+
+  // t is clamped to [0, 1]
+  Vec2 position(f32 t) const;
+  Vec2 tangent(f32 t) const;    // unit, or zero where the curve stalls
+
+  // the t at which the arc length from the start reaches distance, by
+  // binary search in the table; distance is clamped to [0, length()]
+  f32 t_at(f32 distance) const;
+};
+
+// Batch versions. Positions and tangents go to out as x y pairs, so out
+// holds 2 * n numbers.
+void positions(const BezierCurve& c, const f64* ts, u32 n, f64* out);
+void tangents(const BezierCurve& c, const f64* ts, u32 n, f64* out);
+void ts_at(const BezierCurve& c, const f64* distances, u32 n, f64* out);
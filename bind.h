@@ -0,0 +1,441 @@
+// -*- c++ -*-
+#pragma once
+
+// Compile-time binding of plain C++ functions to s7.
+//
+//   static Vec2 vec2_plus(Vec2* a, Vec2* b);
+//   define_function<BIND(vec2_plus)>(sc, "vec2+");
+//
+// Argument unpacking, type checks and the s7 signature are generated from
+// the C++ signature. Arg<T> and Ret<T> describe how a type crosses the
+// boundary; a binding using a type without them does not compile. The
+// optimizer's direct-call variants (d_d, p_pp, ...) are registered too.
+
+#include "misc.h"
+#include "s7/s7.h"
+#include <string>
+#include <type_traits>
+
+#define BIND(f) decltype(&f), &f
+#define BIND_AS(type, f) type, &f    // picks one of overloaded f
+
+template <int...>
+struct Indices
+{
+};
+
+template <int N, int... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...>
+{
+};
+
+template <int... I>
+struct MakeIndices<0, I...>
+{
+  typedef Indices<I...> type;
+};
+
+// is() checks an s7 value, get() unpacks it, type_name() goes to the
+// wrong-type error, predicate() to the signature (0 means any).
+template <typename T>
+struct Arg;
+
+// For types get() narrows: a value that passed is() but does not fit gets
+// an out-of-range error with what check() returns, 0 when it fits.
+template <typename T>
+struct ArgRange
+{
+  static const char* check(s7_pointer) { return 0; }
+};
+
+template <>
+struct Arg<f32>
+{
+  static bool is(s7_pointer p) { return s7_is_number(p); }
+  static f32 get(s7_scheme* sc, s7_pointer p) { return (f32)s7_number_to_real(sc, p); }
+  static const char* type_name() { return "number"; }
+  static const char* predicate() { return "real?"; }
+};
+
+template <>
+struct Arg<f64>
+{
+  static bool is(s7_pointer p) { return s7_is_number(p); }
+  static f64 get(s7_scheme* sc, s7_pointer p) { return s7_number_to_real(sc, p); }
+  static const char* type_name() { return "number"; }
+  static const char* predicate() { return "real?"; }
+};
+
+template <>
+struct Arg<i32>
+{
+  static bool is(s7_pointer p) { return s7_is_integer(p); }
+  static i32 get(s7_scheme*, s7_pointer p) { return (i32)s7_integer(p); }
+  static const char* type_name() { return "integer"; }
+  static const char* predicate() { return "integer?"; }
+};
+
+template <>
+struct ArgRange<i32>
+{
+  static const char* check(s7_pointer p)
+  {
+    const s7_int v = s7_integer(p);
+    return v >= INT32_MIN && v <= INT32_MAX ? 0 : "an integer between -2147483648 and 2147483647";
+  }
+};
+
+template <>
+struct Arg<const char*>
+{
+  static bool is(s7_pointer p) { return s7_is_string(p); }
+  static const char* get(s7_scheme*, s7_pointer p) { return s7_string(p); }
+  static const char* type_name() { return "string"; }
+  static const char* predicate() { return "string?"; }
+};
+
+struct FloatVector
+{
+  s7_pointer obj;
+  s7_double* data;
+  s7_int size;
+};
+
+template <>
+struct Arg<FloatVector>
+{
+  static bool is(s7_pointer p) { return s7_is_float_vector(p); }
+  static FloatVector get(s7_scheme*, s7_pointer p)
+  {
+    return FloatVector{p, s7_float_vector_elements(p), s7_vector_length(p)};
+  }
+  static const char* type_name() { return "float-vector"; }
+  static const char* predicate() { return "float-vector?"; }
+};
+
+struct IntVector
+{
+  s7_pointer obj;
+  s7_int* data;
+  s7_int size;
+};
+
+template <>
+struct Arg<IntVector>
+{
+  static bool is(s7_pointer p) { return s7_is_int_vector(p); }
+  static IntVector get(s7_scheme*, s7_pointer p)
+  {
+    return IntVector{p, s7_int_vector_elements(p), s7_vector_length(p)};
+  }
+  static const char* type_name() { return "int-vector"; }
+  static const char* predicate() { return "int-vector?"; }
+};
+
+template <>
+struct Arg<s7_pointer>
+{
+  static bool is(s7_pointer) { return true; }
+  static s7_pointer get(s7_scheme*, s7_pointer p) { return p; }
+  static const char* type_name() { return "anything"; }
+  static const char* predicate() { return 0; }
+};
+
+// The target of an in-place operation: checked like T*, must not be
+// immutable, and can be handed back to scheme: Ref<Vec2> f(Ref<Vec2> dst).
+template <typename T>
+struct Ref
+{
+  s7_pointer obj;
+  T* p;
+
+  T* operator->() const { return p; }
+  T& operator*() const { return *p; }
+};
+
+template <typename T>
+struct Arg<Ref<T>>
+{
+  static bool is(s7_pointer p) { return Arg<T*>::is(p) && !s7_is_immutable(p); }
+  static Ref<T> get(s7_scheme* sc, s7_pointer p) { return Ref<T>{p, Arg<T*>::get(sc, p)}; }
+  static const char* type_name()
+  {
+    static const std::string name = std::string("a mutable ") + Arg<T*>::type_name();
+    return name.c_str();
+  }
+  static const char* predicate() { return Arg<T*>::predicate(); }
+};
+
+template <typename T>
+struct Ret;
+
+template <typename T>
+struct Ret<Ref<T>>
+{
+  static s7_pointer make(s7_scheme*, const Ref<T>& r) { return r.obj; }
+  static const char* predicate() { return Arg<T*>::predicate(); }
+};
+
+template <>
+struct Ret<f32>
+{
+  static s7_pointer make(s7_scheme* sc, f32 v) { return s7_make_real(sc, v); }
+  static const char* predicate() { return "float?"; }
+};
+
+template <>
+struct Ret<i32>
+{
+  static s7_pointer make(s7_scheme* sc, i32 v) { return s7_make_integer(sc, v); }
+  static const char* predicate() { return "integer?"; }
+};
+
+template <>
+struct Ret<FloatVector>
+{
+  static s7_pointer make(s7_scheme*, const FloatVector& v) { return v.obj; }
+  static const char* predicate() { return "float-vector?"; }
+};
+
+template <>
+struct Ret<bool>
+{
+  static s7_pointer make(s7_scheme* sc, bool v) { return s7_make_boolean(sc, v); }
+  static const char* predicate() { return "boolean?"; }
+};
+
+template <>
+struct Ret<s7_pointer>
+{
+  static s7_pointer make(s7_scheme*, s7_pointer v) { return v; }
+  static const char* predicate() { return 0; }
+};
+
+template <>
+struct Ret<void>
+{
+  static const char* predicate() { return 0; }
+};
+
+template <typename R>
+struct Invoke
+{
+  template <typename F, typename... A>
+  static inline s7_pointer call(s7_scheme* sc, F f, A... a)
+  {
+    return Ret<R>::make(sc, f(a...));
+  }
+};
+
+template <>
+struct Invoke<void>
+{
+  template <typename F, typename... A>
+  static inline s7_pointer call(s7_scheme* sc, F f, A... a)
+  {
+    f(a...);
+    return s7_undefined(sc);
+  }
+};
+
+template <typename T, typename... Rest>
+struct AllOf
+{
+  static constexpr bool value = true;
+};
+
+template <typename T, typename First, typename... Rest>
+struct AllOf<T, First, Rest...>
+{
+  static constexpr bool value = std::is_same<T, First>::value && AllOf<T, Rest...>::value;
+};
+
+template <typename>
+struct AsDouble
+{
+  typedef s7_double type;
+};
+
+template <typename>
+struct AsPointer
+{
+  typedef s7_pointer type;
+};
+
+static inline void set_direct(s7_scheme* sc, s7_pointer f, s7_d_t df) { s7_set_d_function(sc, f, df); }
+static inline void set_direct(s7_scheme* sc, s7_pointer f, s7_d_d_t df) { s7_set_d_d_function(sc, f, df); }
+static inline void set_direct(s7_scheme* sc, s7_pointer f, s7_d_dd_t df) { s7_set_d_dd_function(sc, f, df); }
+static inline void set_direct(s7_scheme* sc, s7_pointer f, s7_d_ddd_t df) { s7_set_d_ddd_function(sc, f, df); }
+static inline void set_direct(s7_scheme* sc, s7_pointer f, s7_d_dddd_t df) { s7_set_d_dddd_function(sc, f, df); }
+static inline void set_direct(s7_scheme* sc, s7_pointer f, s7_d_p_t df) { s7_set_d_p_function(sc, f, df); }
+static inline void set_direct(s7_scheme* sc, s7_pointer f, s7_b_p_t df) { s7_set_b_p_function(sc, f, df); }
+static inline void set_direct(s7_scheme* sc, s7_pointer f, s7_p_p_t df) { s7_set_p_p_function(sc, f, df); }
+static inline void set_direct(s7_scheme* sc, s7_pointer f, s7_p_pp_t df) { s7_set_p_pp_function(sc, f, df); }
+static inline void set_direct(s7_scheme* sc, s7_pointer f, s7_p_ppp_t df) { s7_set_p_ppp_function(sc, f, df); }
+
+static inline s7_pointer predicate_symbol(s7_scheme* sc, const char* predicate)
+{
+  return predicate ? s7_make_symbol(sc, predicate) : s7_t(sc);
+}
+
+enum DirectKind
+{
+  DIRECT_NONE,
+  DIRECT_D,      // all f32 -> f32, up to 4 args: d, d_d .. d_dddd
+  DIRECT_D_P,    // one argument -> f32
+  DIRECT_B_P,    // one argument -> bool
+  DIRECT_P       // 1 to 3 arguments: p_p, p_pp, p_ppp
+};
+
+template <DirectKind K>
+struct DirectTag
+{
+};
+
+template <typename Fn, Fn F>
+struct Binding;
+
+template <typename R, typename... A, R (*F)(A...)>
+struct Binding<R (*)(A...), F>
+{
+  static constexpr int N = sizeof...(A);
+  typedef typename MakeIndices<N>::type Is;
+
+  static constexpr DirectKind kind =
+    (std::is_same<R, f32>::value && AllOf<f32, A...>::value && N <= 4) ? DIRECT_D
+    : (std::is_same<R, f32>::value && N == 1)                          ? DIRECT_D_P
+    : (std::is_same<R, bool>::value && N == 1)                         ? DIRECT_B_P
+    : (!std::is_same<R, void>::value && N >= 1 && N <= 3)              ? DIRECT_P
+                                                                       : DIRECT_NONE;
+
+  static const char* name;
+  static s7_scheme* scheme;    // for the direct variants that get no s7_scheme*
+
+  template <int... I>
+  static inline s7_pointer check(s7_scheme* sc, const s7_pointer* argv, Indices<I...>)
+  {
+    const bool ok[] = {true, Arg<A>::is(argv[I])...};
+    const char* expected[] = {0, Arg<A>::type_name()...};
+    const char* (*const range[])(s7_pointer) = {0, &ArgRange<A>::check...};
+    for (int i = 1; i <= N; i++) {
+      if (!ok[i]) {
+        return s7_wrong_type_arg_error(sc, name, i, argv[i - 1], expected[i]);
+      }
+      if (const char* r = range[i](argv[i - 1])) {
+        return s7_out_of_range_error(sc, name, i, argv[i - 1], r);
+      }
+    }
+    return 0;
+  }
+
+  template <int... I>
+  static inline s7_pointer apply(s7_scheme* sc, const s7_pointer* argv, Indices<I...>)
+  {
+    (void)argv;
+    return Invoke<R>::call(sc, F, Arg<A>::get(sc, argv[I])...);
+  }
+
+  static inline s7_pointer apply_checked(s7_scheme* sc, const s7_pointer* argv)
+  {
+    if (auto err = check(sc, argv, Is())) {
+      return err;
+    }
+    return apply(sc, argv, Is());
+  }
+
+  static s7_pointer call(s7_scheme* sc, s7_pointer args)
+  {
+    s7_pointer argv[N + 1];
+    for (int i = 0; i < N; i++) {
+      argv[i] = s7_car(args);
+      args = s7_cdr(args);
+    }
+    return apply_checked(sc, argv);
+  }
+
+  static s7_double d(typename AsDouble<A>::type... x)
+  {
+    return F(A(x)...);
+  }
+
+  // a failed check raises the s7 error and does not return
+  static s7_double d_p(s7_pointer x)
+  {
+    check(scheme, &x, Is());
+    return F(Arg<A>::get(scheme, x)...);
+  }
+
+  static bool b_p(s7_pointer x)
+  {
+    check(scheme, &x, Is());
+    return F(Arg<A>::get(scheme, x)...);
+  }
+
+  static s7_pointer p(s7_scheme* sc, typename AsPointer<A>::type... x)
+  {
+    const s7_pointer argv[N + 1] = {x...};
+    return apply_checked(sc, argv);
+  }
+
+  static void set_direct(s7_scheme*, s7_pointer, DirectTag<DIRECT_NONE>) {}
+  static void set_direct(s7_scheme* sc, s7_pointer f, DirectTag<DIRECT_D>) { ::set_direct(sc, f, &d); }
+  static void set_direct(s7_scheme* sc, s7_pointer f, DirectTag<DIRECT_D_P>) { ::set_direct(sc, f, &d_p); }
+  static void set_direct(s7_scheme* sc, s7_pointer f, DirectTag<DIRECT_B_P>) { ::set_direct(sc, f, &b_p); }
+  static void set_direct(s7_scheme* sc, s7_pointer f, DirectTag<DIRECT_P>) { ::set_direct(sc, f, &p); }
+
+  static s7_pointer signature(s7_scheme* sc)
+  {
+    return s7_make_signature(sc, N + 1, predicate_symbol(sc, Ret<R>::predicate()),
+                             predicate_symbol(sc, Arg<A>::predicate())...);
+  }
+
+  static void bind(s7_scheme* sc, const char* _name)
+  {
+    scheme = sc;
+    name = _name;
+  }
+};
+
+template <typename R, typename... A, R (*F)(A...)>
+const char* Binding<R (*)(A...), F>::name = 0;
+
+template <typename R, typename... A, R (*F)(A...)>
+s7_scheme* Binding<R (*)(A...), F>::scheme = 0;
+
+template <typename Fn, Fn F>
+s7_pointer define_function(s7_scheme* sc, const char* name, const char* doc = 0)
+{
+  typedef Binding<Fn, F> B;
+  B::bind(sc, name);
+  // s7_define_typed_function returns the symbol, not the function
+  s7_define_typed_function(sc, name, B::call, B::N, 0, false, doc, B::signature(sc));
+  s7_pointer f = s7_name_to_value(sc, name);
+  B::set_direct(sc, f, DirectTag<B::kind>());
+  return f;
+}
+
+// as define_function, but not bound to name, which is only for errors
+template <typename Fn, Fn F>
+s7_pointer make_function(s7_scheme* sc, const char* name, const char* doc = 0)
+{
+  typedef Binding<Fn, F> B;
+  B::bind(sc, name);
+  s7_pointer f = s7_make_typed_function(sc, name, B::call, B::N, 0, false, doc, B::signature(sc));
+  B::set_direct(sc, f, DirectTag<B::kind>());
+  return f;
+}
+
+// getter/setter pair as one dilambda, e.g. (vec2-x v) and (set! (vec2-x v) 1)
+template <typename GetFn, GetFn Get, typename SetFn, SetFn Set>
+s7_pointer define_accessor(s7_scheme* sc, const char* name, const char* doc = 0)
+{
+  typedef Binding<GetFn, Get> G;
+  typedef Binding<SetFn, Set> S;
+  G::bind(sc, name);
+  S::bind(sc, name);
+  s7_pointer f = s7_typed_dilambda(sc, name, G::call, G::N, 0, S::call, S::N, 0, doc,
+                                   G::signature(sc), S::signature(sc));
+  G::set_direct(sc, f, DirectTag<G::kind>());
+  s7_define_variable(sc, name, f);
+  return f;
+}
@@ -0,0 +1,248 @@
+// -*- c++ -*-
+#include "collide.h"
+
+#include "simd.h"
+
+bool ray_circle(const Vec2& o, const Vec2& d, f32 max_t, const Vec2& c, f32 r, f32* t)
+{
+  const Vec2 m = o - c;
+  const f32 k = length2(m) - r * r;
+  if (k <= 0) {
+    *t = 0;
+    return true;
+  }
+  // |m + d t|^2 = r^2, the smaller root; both are negative when moving away
+  const f32 b = dot(m, d), a = length2(d);
+  const f32 disc = b * b - a * k;
+  if (disc < 0 || a == 0) {
+    return false;
+  }
+  const f32 s = (-b - sqrtf(disc)) / a;
+  if (!(s >= 0 && s <= max_t)) {
+    return false;
+  }
+  *t = s;
+  return true;
+}
+
+bool ray_segment(const Vec2& o, const Vec2& d, f32 r, f32 max_t, const Vec2& a, const Vec2& b, f32* t)
+{
+  if (segment_distance2(o, a, b) <= r * r) {
+    *t = 0;
+    return true;
+  }
+  f32 best = FLT_MAX;
+
+  // the side facing o, r away from the segment's line: cross(e, m) is
+  // the distance from it times |e|, and changes by cross(e, d) per unit t
+  const Vec2 e = b - a, m = o - a;
+  const f32 len2 = length2(e);
+  if (len2 > 0) {
+    const f32 s0 = cross(e, m), ds = cross(e, d);
+    const f32 side = s0 < 0 ? -r * sqrtf(len2) : r * sqrtf(len2);
+    const f32 tf = (side - s0) / ds;
+    const f32 u = dot(m + d * tf, e);
+    if (tf >= 0 && tf <= max_t && u >= 0 && u <= len2) {
+      best = tf;
+    }
+  }
+
+  // the round ends
+  f32 tc;
+  if (ray_circle(o, d, max_t, a, r, &tc)) {
+    best = std::min(best, tc);
+  }
+  if (ray_circle(o, d, max_t, b, r, &tc)) {
+    best = std::min(best, tc);
+  }
+  if (best == FLT_MAX) {
+    return false;
+  }
+  *t = best;
+  return true;
+}
+
+namespace
+{
+// hit indices and times into the caller's buffers, counting past their end
+struct Hits
+{
+  i64* hits;
+  f64* times;
+  u32 capacity;
+  u32 n;
+
+  template <typename L>
+  void push(u32 i, const Maskx<L>& hit)
+  {
+    const u32 bits = hit.bits();
+    for (u32 j = 0; bits >> j; j++) {
+      if (bits >> j & 1) {
+        if (n < capacity) {
+          hits[n] = i + j;
+        }
+        n++;
+      }
+    }
+  }
+
+  template <typename L>
+  void push(u32 i, const Maskx<L>& hit, const F32x<L>& t)
+  {
+    const u32 bits = hit.bits();
+    if (!bits) {
+      return;
+    }
+    f32 ts[L::width];
+    t.store(ts);
+    for (u32 j = 0; j < L::width; j++) {
+      if (bits >> j & 1) {
+        if (n < capacity) {
+          hits[n] = i + j;
+          times[n] = ts[j];
+        }
+        n++;
+      }
+    }
+  }
+};
+}
+
+// as ray_circle, m = o - c, dd = length2(d)
+template <typename L>
+static inline Maskx<L> ray_circle_x(const Vec2x<L>& m, const Vec2x<L>& d, const F32x<L>& dd, const F32x<L>& r,
+                                    const F32x<L>& max_t, F32x<L>& t)
+{
+  typedef F32x<L> F;
+  const F zero = F::splat(0.0f);
+  const F k = length2(m) - r * r;
+  const F b = dot(m, d);
+  const F disc = b * b - dd * k;
+  const F s = (-b - sqrt(max(disc, zero))) / dd;    // NaN or infinite when d = 0
+  const Maskx<L> inside = k <= zero;
+  t = select(inside, zero, s);
+  return inside | ((disc >= zero) & (s >= zero) & (s <= max_t));
+}
+
+template <typename L>
+static u32 overlapping_circle_k(const Vec2Buffer& centers, const f64* radii, const Vec2& c, f32 r, u32 i,
+                                Hits& h)
+{
+  typedef F32x<L> F;
+  const Vec2x<L> vc = Vec2x<L>::splat(c);
+  const F vr = F::splat(r);
+  const u32 n = centers.size();
+  for (; i + L::width <= n; i += L::width) {
+    const Vec2x<L> p = Vec2x<L>::load(centers.xs.data() + i, centers.ys.data() + i);
+    h.push(i, length2(p - vc) <= sqr(vr + F::load(radii + i)));
+  }
+  return i;
+}
+
+u32 circles_overlapping_circle(const Vec2Buffer& centers, const f64* radii, const Vec2& c, f32 r,
+                               i64* hits, u32 capacity)
+{
+  Hits h = {hits, 0, capacity, 0};
+  u32 i = overlapping_circle_k<Wide>(centers, radii, c, r, 0, h);
+  overlapping_circle_k<Scalar>(centers, radii, c, r, i, h);
+  return h.n;
+}
+
+template <typename L>
+static u32 touching_segment_k(const Vec2Buffer& centers, const f64* radii, const Vec2& a, const Vec2& b,
+                              u32 i, Hits& h)
+{
+  typedef F32x<L> F;
+  const Vec2x<L> va = Vec2x<L>::splat(a), e = Vec2x<L>::splat(b - a);
+  const f32 len2 = length2(b - a);
+  const F vlen2 = F::splat(len2);
+  const u32 n = centers.size();
+  for (; i + L::width <= n; i += L::width) {
+    const Vec2x<L> m = Vec2x<L>::load(centers.xs.data() + i, centers.ys.data() + i) - va;
+    const F h01 = len2 > 0 ? clamp01(dot(m, e) / vlen2) : F::splat(0.0f);
+    h.push(i, length2(m - e * h01) <= sqr(F::load(radii + i)));
+  }
+  return i;
+}
+
+u32 circles_touching_segment(const Vec2Buffer& centers, const f64* radii, const Vec2& a, const Vec2& b,
+                             i64* hits, u32 capacity)
+{
+  Hits h = {hits, 0, capacity, 0};
+  u32 i = touching_segment_k<Wide>(centers, radii, a, b, 0, h);
+  touching_segment_k<Scalar>(centers, radii, a, b, i, h);
+  return h.n;
+}
+
+template <typename L>
+static u32 ray_circles_k(const Vec2& o, const Vec2& d, f32 max_t, const Vec2Buffer& centers, const f64* radii,
+                         u32 i, Hits& h)
+{
+  typedef F32x<L> F;
+  const Vec2x<L> vo = Vec2x<L>::splat(o), vd = Vec2x<L>::splat(d);
+  const F dd = F::splat(length2(d)), vmax = F::splat(max_t);
+  const u32 n = centers.size();
+  for (; i + L::width <= n; i += L::width) {
+    const Vec2x<L> m = vo - Vec2x<L>::load(centers.xs.data() + i, centers.ys.data() + i);
+    F t;
+    const Maskx<L> hit = ray_circle_x(m, vd, dd, F::load(radii + i), vmax, t);
+    h.push(i, hit, t);
+  }
+  return i;
+}
+
+u32 ray_circles(const Vec2& o, const Vec2& d, f32 max_t, const Vec2Buffer& centers, const f64* radii,
+                i64* hits, f64* times, u32 capacity)
+{
+  Hits h = {hits, times, capacity, 0};
+  u32 i = ray_circles_k<Wide>(o, d, max_t, centers, radii, 0, h);
+  ray_circles_k<Scalar>(o, d, max_t, centers, radii, i, h);
+  return h.n;
+}
+
+// as ray_segment, each lane its own segment
+template <typename L>
+static u32 ray_segments_k(const Vec2& o, const Vec2& d, f32 r, f32 max_t, const Vec2Buffer& starts,
+                          const Vec2Buffer& ends, u32 i, Hits& h)
+{
+  typedef F32x<L> F;
+  const F zero = F::splat(0.0f), none = F::splat(FLT_MAX);
+  const Vec2x<L> vo = Vec2x<L>::splat(o), vd = Vec2x<L>::splat(d);
+  const F vr = F::splat(r), rr = F::splat(r * r), dd = F::splat(length2(d)), vmax = F::splat(max_t);
+  const u32 n = starts.size();
+  for (; i + L::width <= n; i += L::width) {
+    const Vec2x<L> a = Vec2x<L>::load(starts.xs.data() + i, starts.ys.data() + i);
+    const Vec2x<L> b = Vec2x<L>::load(ends.xs.data() + i, ends.ys.data() + i);
+    const Vec2x<L> e = b - a, m = vo - a;
+    const F len2 = length2(e);
+    const Maskx<L> long_enough = len2 > zero;
+
+    const F h01 = select(long_enough, clamp01(dot(m, e) / len2), zero);
+    const Maskx<L> inside = length2(m - e * h01) <= rr;
+
+    const F s0 = cross(e, m), ds = cross(e, vd);
+    const F side = vr * sqrt(len2);
+    const F tf = (select(s0 < zero, -side, side) - s0) / ds;
+    const F u = dot(m + vd * tf, e);
+    const Maskx<L> face = long_enough & (tf >= zero) & (tf <= vmax) & (u >= zero) & (u <= len2);
+    F best = select(face, tf, none);
+
+    F tc;
+    const Maskx<L> cap_a = ray_circle_x(m, vd, dd, vr, vmax, tc);
+    best = select(cap_a, min(best, tc), best);
+    const Maskx<L> cap_b = ray_circle_x(vo - b, vd, dd, vr, vmax, tc);
+    best = select(cap_b, min(best, tc), best);
+
+    h.push(i, inside | face | cap_a | cap_b, select(inside, zero, best));
+  }
+  return i;
+}
+
+u32 ray_segments(const Vec2& o, const Vec2& d, f32 r, f32 max_t, const Vec2Buffer& starts,
+                 const Vec2Buffer& ends, i64* hits, f64* times, u32 capacity)
+{
+  Hits h = {hits, times, capacity, 0};
+  u32 i = ray_segments_k<Wide>(o, d, r, max_t, starts, ends, 0, h);
+  ray_segments_k<Scalar>(o, d, r, max_t, starts, ends, i, h);
+  return h.n;
+}
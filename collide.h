@@ -0,0 +1,51 @@
+// -*- c++ -*-
+#pragma once
+
+#include "misc.h"
+#include "vec2_buffer.h"
+
+// Collision tests of one shape against many: circles given as centres in
+// a Vec2Buffer and radii in a float-vector, segments as two Vec2Buffers of
+// end points. The scalar tests come first; the batch kernels compute the
+// same thing lane-wise.
+//
+// Rays are o + d t for t in [0, max_t]: with d the displacement over a
+// frame and max_t = 1, t is the time of impact within the frame. A ray
+// that starts inside a shape hits it at t = 0.
+
+inline bool circles_overlap(const Vec2& a, f32 ra, const Vec2& b, f32 rb)
+{
+  return length2(b - a) <= sqr(ra + rb);
+}
+
+// squared distance from p to the segment a b
+inline f32 segment_distance2(const Vec2& p, const Vec2& a, const Vec2& b)
+{
+  const Vec2 e = b - a, m = p - a;
+  const f32 len2 = length2(e);
+  const f32 h = len2 > 0 ? clamp01(dot(m, e) / len2) : 0;
+  return length2(m - e * h);
+}
+
+inline bool circle_touches_segment(const Vec2& c, f32 r, const Vec2& a, const Vec2& b)
+{
+  return segment_distance2(c, a, b) <= r * r;
+}
+
+bool ray_circle(const Vec2& o, const Vec2& d, f32 max_t, const Vec2& c, f32 r, f32* t);
+
+// A circle of radius r moving along the ray against the segment a b (a
+// capsule around it); r = 0 is a plain ray.
+bool ray_segment(const Vec2& o, const Vec2& d, f32 r, f32 max_t, const Vec2& a, const Vec2& b, f32* t);
+
+// Batch versions. They write the indices of the shapes hit to hits (and
+// the times to times), in index order, at most capacity of them, and
+// return how many there were in total.
+u32 circles_overlapping_circle(const Vec2Buffer& centers, const f64* radii, const Vec2& c, f32 r,
+                               i64* hits, u32 capacity);
+u32 circles_touching_segment(const Vec2Buffer& centers, const f64* radii, const Vec2& a, const Vec2& b,
+                             i64* hits, u32 capacity);
+u32 ray_circles(const Vec2& o, const Vec2& d, f32 max_t, const Vec2Buffer& centers, const f64* radii,
+                i64* hits, f64* times, u32 capacity);
+u32 ray_segments(const Vec2& o, const Vec2& d, f32 r, f32 max_t, const Vec2Buffer& starts,
+                 const Vec2Buffer& ends, i64* hits, f64* times, u32 capacity);
@@ -0,0 +1,358 @@
+// -*- c++ -*-
+#pragma once
+
+// PoolAllocator for objects allocated on one thread and freed on another
+// (workers produce values, the interpreter frees them from its GC).
+//
+// Each thread keeps two magazines of up to M free objects, so allocate()
+// and free() normally touch only thread-local memory. A magazine is a
+// small header; the free objects themselves link it together. When both are empty
+// (or full) the thread trades a magazine with the global depot, two
+// lock-free stacks of full and empty magazines. Only carving new blocks
+// and creating magazines take the mutex.
+//
+// There is one ConcurrentPool per T, since the thread caches are per type.
+// Threads that used the pool must have exited (or stopped using it) before
+// it is destroyed.
+
+#include "misc.h"
+#include <atomic>
+#include <mutex>
+
+template <typename T, u32 M = 64>
+class ConcurrentPool
+{
+  union Slot
+  {
+    T value;
+    Slot* next;
+  };
+
+  struct Magazine
+  {
+    std::atomic<Magazine*> next;
+    u32 count;
+    Slot* head;
+
+    inline T* pop()
+    {
+      Slot* s = head;
+      head = s->next;
+      count--;
+      return &s->value;
+    }
+
+    inline void push(Slot* s)
+    {
+      s->next = head;
+      head = s;
+      count++;
+    }
+  };
+
+  // Treiber stack; the head packs the pointer with a 16 bit version
+  // against ABA. Magazines are never freed while the pool lives, so
+  // reading next from a magazine popped by another thread is safe.
+  class Stack
+  {
+    static_assert(sizeof(void*) == 8, "Stack packs 48 bit pointers");
+    static const u64 PTR_MASK = (1ull << 48) - 1;
+    std::atomic<u64> head{0};
+
+  public:
+    void push(Magazine* m)
+    {
+      u64 old = head.load(std::memory_order_relaxed);
+      u64 tagged;
+      do {
+        m->next.store((Magazine*)(old & PTR_MASK), std::memory_order_relaxed);
+        tagged = (u64)m | ((old & ~PTR_MASK) + (1ull << 48));
+      } while (!head.compare_exchange_weak(old, tagged, std::memory_order_release,
+                                           std::memory_order_relaxed));
+    }
+
+    Magazine* pop()
+    {
+      u64 old = head.load(std::memory_order_acquire);
+      Magazine* m;
+      u64 tagged;
+      do {
+        m = (Magazine*)(old & PTR_MASK);
+        if (!m) {
+          return 0;
+        }
+        tagged = (u64)m->next.load(std::memory_order_relaxed) | ((old & ~PTR_MASK) + (1ull << 48));
+      } while (!head.compare_exchange_weak(old, tagged, std::memory_order_acquire,
+                                           std::memory_order_acquire));
+      return m;
+    }
+  };
+
+  // trivially constructible and destructible, so the hot path is a plain
+  // TLS access; Flusher hands the magazines back when the thread exits
+  struct Cache
+  {
+    Magazine* loaded;
+    Magazine* previous;
+  };
+
+  struct Flusher
+  {
+    ~Flusher()
+    {
+      if (instance) {
+        instance->flush();
+      }
+    }
+  };
+
+  static thread_local Cache cache;
+  static ConcurrentPool* instance;
+
+  Magazine* new_magazine()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Magazine* m = new Magazine;
+    m->next.store(0, std::memory_order_relaxed);
+    m->count = 0;
+    m->head = 0;
+    magazines.push_back(m);
+    return m;
+  }
+
+  void push_full(Magazine* m)
+  {
+    depot_objects.fetch_add(m->count, std::memory_order_relaxed);
+    full.push(m);
+  }
+
+  Magazine* pop_full()
+  {
+    Magazine* m = full.pop();
+    if (m) {
+      depot_objects.fetch_sub(m->count, std::memory_order_relaxed);
+    }
+    return m;
+  }
+
+  Magazine* empty_magazine()
+  {
+    Magazine* m = empty.pop();
+    return m ? m : new_magazine();
+  }
+
+  void carve(Magazine* m)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (m->count < M) {
+      if (used == grow) {
+        mem.push_back(new Slot[grow]);
+        used = 0;
+      }
+      m->push(mem.back() + used++);
+    }
+  }
+
+  void attach()
+  {
+    static thread_local Flusher flusher;    // constructed here, once per thread
+    (void)flusher;
+    cache.loaded = empty_magazine();
+    cache.previous = empty_magazine();
+  }
+
+  T* allocate_slow()
+  {
+    if (!cache.loaded) {
+      attach();
+    }
+    if (cache.previous->count > 0) {
+      std::swap(cache.loaded, cache.previous);
+    } else if (Magazine* m = pop_full()) {
+      empty.push(cache.previous);
+      cache.previous = cache.loaded;
+      cache.loaded = m;
+    } else {
+      carve(cache.loaded);
+    }
+    return cache.loaded->pop();
+  }
+
+  void free_slow(T* p)
+  {
+    if (!cache.loaded) {
+      attach();
+    }
+    if (cache.previous->count < M) {
+      std::swap(cache.loaded, cache.previous);
+    } else {
+      push_full(cache.previous);
+      cache.previous = cache.loaded;
+      cache.loaded = empty_magazine();
+    }
+    cache.loaded->push((Slot*)p);
+  }
+
+  const u32 grow;
+  u32 used;
+  std::mutex mutex;                    // guards mem, used and magazines
+  std::vector<Slot*> mem;              // blocks of grow objects
+  std::vector<Magazine*> magazines;    // all of them, for the destructor
+  Stack full;                          // non-empty magazines
+  Stack empty;
+  std::atomic<u64> depot_objects{0};    // free objects in full
+  u32 settled = 0;                      // for maybe_trim
+
+public:
+  ConcurrentPool(u32 _grow) : grow(_grow), used(_grow)
+  {
+    static_assert(std::is_pod<T>::value, "ConcurrentPool value must be POD");
+    assert(!instance);
+    instance = this;
+  }
+
+  ~ConcurrentPool()
+  {
+    cache.loaded = cache.previous = 0;
+    instance = 0;
+    for (const auto& p : mem) {
+      delete [] p;
+    }
+    for (const auto& m : magazines) {
+      delete m;
+    }
+  }
+
+  inline T* allocate()
+  {
+    Magazine* m = cache.loaded;
+    if (m && m->count > 0) {
+      return m->pop();
+    }
+    return allocate_slow();
+  }
+
+  inline void free(T* p)
+  {
+    assert(p);
+    Magazine* m = cache.loaded;
+    if (m && m->count < M) {
+      m->push((Slot*)p);
+      return;
+    }
+    free_slow(p);
+  }
+
+  // Deletes blocks whose objects are all free, except for reserve of
+  // them. Only objects in the depot and the calling thread's cache are
+  // seen; a block with a free object sitting in another thread's cache
+  // counts as live. Returns the number of blocks released.
+  u32 trim(u32 reserve = 0)
+  {
+    flush();
+    std::vector<Magazine*> held;
+    while (Magazine* m = pop_full()) {
+      held.push_back(m);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const u32 n = mem.size();
+    std::vector<u32> live_in(n, grow);    // per block
+    if (n) {
+      live_in[n - 1] = used;
+    }
+    BlockIndex<Slot> index(mem);
+    for (Magazine* m : held) {
+      for (Slot* s = m->head; s; s = s->next) {
+        live_in[index.find(s)]--;
+      }
+    }
+
+    std::vector<bool> release(n, false);
+    u32 released = 0;
+    for (u32 i = 0, spare = 0; i < n; i++) {
+      if (live_in[i] == 0 && spare++ >= reserve) {
+        release[i] = true;
+        released++;
+      }
+    }
+
+    // repack the surviving objects and hand the magazines back
+    std::vector<Slot*> keep;
+    for (Magazine* m : held) {
+      for (Slot* s = m->head; s; s = s->next) {
+        if (!release[index.find(s)]) {
+          keep.push_back(s);
+        }
+      }
+    }
+    for (Magazine* m : held) {
+      m->count = 0;
+      m->head = 0;
+      while (m->count < M && !keep.empty()) {
+        m->push(keep.back());
+        keep.pop_back();
+      }
+      if (m->count) {
+        push_full(m);
+      } else {
+        empty.push(m);
+      }
+    }
+
+    if (released) {
+      if (release[n - 1]) {
+        used = grow;    // carve from a fresh block next time
+      }
+      std::vector<Slot*> kept;
+      for (u32 i = 0; i < n; i++) {
+        if (release[i]) {
+          delete [] mem[i];
+        } else {
+          kept.push_back(mem[i]);
+        }
+      }
+      mem.swap(kept);
+      release_free_memory();
+    }
+    return released;
+  }
+
+  // Call from one thread only, once per frame or when idle. It goes by
+  // the objects free in the depot; thread caches don't count.
+  u32 maybe_trim(const TrimPolicy& policy)
+  {
+    if (!policy.due(settled, depot_objects.load(std::memory_order_relaxed), grow)) {
+      return 0;
+    }
+    return trim(policy.reserve_blocks);
+  }
+
+  u32 blocks()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return mem.size();
+  }
+
+  // gives the calling thread's cached objects back to the depot
+  void flush()
+  {
+    Magazine* ms[] = {cache.loaded, cache.previous};
+    for (Magazine* m : ms) {
+      if (m) {
+        if (m->count) {
+          push_full(m);
+        } else {
+          empty.push(m);
+        }
+      }
+    }
+    cache.loaded = cache.previous = 0;
+  }
+};
+
+template <typename T, u32 M>
+thread_local typename ConcurrentPool<T, M>::Cache ConcurrentPool<T, M>::cache;
+
+template <typename T, u32 M>
+ConcurrentPool<T, M>* ConcurrentPool<T, M>::instance = 0;
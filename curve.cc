@@ -0,0 +1,48 @@
+// -*- c++ -*-
+#include "curve.h"
+
+#include "simd.h"
+
+// [0, 1], NaN to 1 as in values_k
+static inline f32 unit(f32 t)
+{
+  return t < 1 ? (t > 0 ? t : 0) : 1;
+}
+
+f32 Curve::value(f32 t) const
+{
+  const f32 x = unit(t) * SEGMENTS;
+  const u32 i = u32(x);
+  return lerp(ys[i], ys[i + 1], x - i);
+}
+
+f32 spline_value(const f64* points, u32 n, f32 t)
+{
+  if (n < 2) {
+    return n ? points[0] : 0;
+  }
+  const f32 x = unit(t) * (n - 1);
+  const u32 i = std::min(u32(x), n - 2);
+  const f32 y0 = points[i ? i - 1 : 0];
+  const f32 y3 = points[std::min(i + 2, n - 1)];
+  return hermite_interp(y0, points[i], points[i + 1], y3, x - i);
+}
+
+// clamp01 takes NaN to 1 here, so no index leaves the table
+template <typename L>
+static u32 values_k(const Curve& c, const f64* ts, u32 i, u32 n, f64* out)
+{
+  typedef F32x<L> F;
+  for (; i + L::width <= n; i += L::width) {
+    const F x = clamp01(F::load(ts + i)) * F::splat(Curve::SEGMENTS);
+    const F k = trunc(x);
+    lerp(F::gather(c.ys, k), F::gather(c.ys + 1, k), x - k).store(out + i);
+  }
+  return i;
+}
+
+void values(const Curve& c, const f64* ts, u32 n, f64* out)
+{
+  u32 i = values_k<Wide>(c, ts, 0, n, out);
+  values_k<Scalar>(c, ts, i, n, out);
+}
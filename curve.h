@@ -0,0 +1,36 @@
+// -*- c++ -*-
+#pragma once
+
+#include "misc.h"
+
+// A function of t in [0, 1] baked into a table, for easings too costly to
+// evaluate per sample (elastic, bounce) and for splines drawn by hand.
+// value(t) is one lookup and a lerp between neighbouring samples; with
+// 1024 segments that is within 5e-5 of a smooth easing like elastic, and
+// within 2e-3 in the one segment around each of bounce's corners.
+struct Curve
+{
+  static const u32 SEGMENTS = 1024;
+
+  // ys[i] = f(i / SEGMENTS); the last one twice, so t = 1 needs no branch
+  f32 ys[SEGMENTS + 2];
+
+  template <typename F>
+  explicit Curve(F f)
+  {
+    for (u32 i = 0; i <= SEGMENTS; i++) {
+      ys[i] = f(f32(i) / SEGMENTS);
+    }
+    ys[SEGMENTS + 1] = ys[SEGMENTS];
+  }
+
+  // t is clamped to [0, 1]
+  f32 value(f32 t) const;
+};
+
+// Catmull-Rom (hermite_interp) through n >= 1 values spaced evenly over
+// [0, 1], the end values repeated for the outer tangents
+f32 spline_value(const f64* points, u32 n, f32 t);
+
+// value() of each of the n ts into out
+void values(const Curve& c, const f64* ts, u32 n, f64* out);
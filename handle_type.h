@@ -0,0 +1,164 @@
+// -*- c++ -*-
+#pragma once
+
+// s7 c-types whose value is a Handle into a SlotMap instead of a pointer:
+//
+//   static SlotMap<Body> bodies;
+//   template <> struct Arg<Body*> : HandleArg<Body> {};
+//
+//   define_handle_type<Body>(sc, "body", &bodies);
+//
+// The handle is stored in the c-object's value field, so the native side
+// is free to move, sort and erase its objects; the scheme value just goes
+// stale. A binding taking Body* rejects a stale handle with a wrong-type
+// error ("a live body"); bindings taking or returning Handle<Body> pass
+// the handle itself. Defines body?, body-live?, printing as <body 3.1>
+// (index.generation), and equal?/hashing by handle.
+
+#include "misc.h"
+#include "bind.h"
+#include <string>
+#include <stdio.h>
+#include <string.h>
+
+template <typename T>
+struct HandleType
+{
+  static_assert(sizeof(Handle<T>) <= sizeof(void*), "Handle must fit into c-object value");
+
+  static int tag;
+  static const char* name;
+  static std::string predicate;
+  static std::string live_name;    // "a live body", for wrong-type errors
+  static SlotMap<T>* map;
+
+  static bool is(s7_pointer p)
+  {
+    return s7_is_c_object(p) && s7_c_object_type(p) == tag;
+  }
+
+  static Handle<T> handle(s7_pointer p)
+  {
+    Handle<T> h;
+    memcpy(&h, s7_c_object_inline_value(p), sizeof(h));
+    return h;
+  }
+
+  // 0 if stale
+  static T* value(s7_pointer p)
+  {
+    return map->get(handle(p));
+  }
+
+  static s7_pointer make(s7_scheme* sc, Handle<T> h)
+  {
+    void* value = 0;
+    memcpy(&value, &h, sizeof(h));
+    return s7_make_c_object_without_gc(sc, tag, value);
+  }
+
+  static bool is_live(s7_pointer p)
+  {
+    return is(p) && map->contains(handle(p));
+  }
+
+  static s7_pointer to_string(s7_scheme* sc, s7_pointer args)
+  {
+    s7_pointer o = s7_car(args);
+    if (!is(o)) {
+      return s7_wrong_type_arg_error(sc, "handle to string", 1, o, name);
+    }
+    const Handle<T> h = handle(o);
+    char buf[256];
+    snprintf(buf, sizeof(buf), "<%s %u.%u%s>", name, h.index, h.generation,
+             map->contains(h) ? "" : " stale");
+    return s7_make_string(sc, buf);
+  }
+
+  static s7_pointer is_equal(s7_scheme* sc, s7_pointer args)
+  {
+    s7_pointer a = s7_car(args), b = s7_cadr(args);
+    return s7_make_boolean(sc, is(a) && is(b) && handle(a) == handle(b));
+  }
+
+  static s7_int hash(s7_scheme*, s7_pointer o)
+  {
+    const Handle<T> h = handle(o);
+    u64 k = ((u64)h.generation << 32 | h.index) * 0x9e3779b97f4a7c15ull;
+    k ^= k >> 31;
+    return (s7_int)(k >> 1);
+  }
+};
+
+template <typename T>
+int HandleType<T>::tag = 0;
+
+template <typename T>
+const char* HandleType<T>::name = 0;
+
+template <typename T>
+std::string HandleType<T>::predicate;
+
+template <typename T>
+std::string HandleType<T>::live_name;
+
+template <typename T>
+SlotMap<T>* HandleType<T>::map = 0;
+
+// the object behind a live handle
+template <typename T>
+struct HandleArg
+{
+  static bool is(s7_pointer p) { return HandleType<T>::is_live(p); }
+  static T* get(s7_scheme*, s7_pointer p) { return HandleType<T>::value(p); }
+  static const char* type_name() { return HandleType<T>::live_name.c_str(); }
+  static const char* predicate() { return HandleType<T>::predicate.c_str(); }
+};
+
+// the handle itself, live or not
+template <typename T>
+struct Arg<Handle<T>>
+{
+  static bool is(s7_pointer p) { return HandleType<T>::is(p); }
+  static Handle<T> get(s7_scheme*, s7_pointer p) { return HandleType<T>::handle(p); }
+  static const char* type_name() { return HandleType<T>::name; }
+  static const char* predicate() { return HandleType<T>::predicate.c_str(); }
+};
+
+template <typename T>
+struct Ret<Handle<T>>
+{
+  static s7_pointer make(s7_scheme* sc, Handle<T> h) { return HandleType<T>::make(sc, h); }
+  static const char* predicate() { return HandleType<T>::predicate.c_str(); }
+};
+
+template <typename T>
+static bool is_handle(s7_pointer o)
+{
+  return HandleType<T>::is(o);
+}
+
+template <typename T>
+static bool is_live_handle(s7_pointer o)
+{
+  return HandleType<T>::is_live(o);
+}
+
+template <typename T>
+void define_handle_type(s7_scheme* sc, const char* name, SlotMap<T>* map)
+{
+  typedef HandleType<T> H;
+  H::name = name;
+  H::predicate = std::string(name) + "?";
+  H::live_name = std::string("a live ") + name;
+  H::map = map;
+  H::tag = s7_make_c_type(sc, name);
+  s7_c_type_set_to_string(sc, H::tag, H::to_string);
+  s7_c_type_set_is_equal(sc, H::tag, H::is_equal);
+  s7_c_type_set_is_equivalent(sc, H::tag, H::is_equal);
+  s7_c_type_set_hash(sc, H::tag, H::hash);
+
+  define_function<BIND(is_handle<T>)>(sc, H::predicate.c_str());
+  static const std::string live = std::string(name) + "-live?";
+  define_function<BIND(is_live_handle<T>)>(sc, live.c_str());
+}
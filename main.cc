@@ -1,312 +1,1652 @@
 #include "misc.h"
+#include "bind.h"
+#include "pod_type.h"
+#include "size_class_pool.h"
+#include "vec2_buffer.h"
+#include "random.h"
+#include "bezier.h"
+#include "curve.h"
+#include "spatial_hash.h"
+#include "collide.h"
+#include "tween.h"
+#include "handle_type.h"
 #define STS_NET_IMPLEMENTATION
 #include "sts_net/sts_net.h"
 #include "s7/s7.h"
 #include <string>
+#include <chrono>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdarg.h>
+#include <string.h>
+
+static sts_net_set_t set;
+static sts_net_socket_t server;
+static sts_net_socket_t clients[STS_NET_SET_SOCKETS];
+
+static void panic(const char* msg)
+{
+  fprintf(stderr, "PANIC: %s\n\n", msg);
+  abort();
+}
+
+static void load_script(s7_scheme* sc, const char* name)
+{
+  s7_pointer res = s7_load(sc, name);
+  if (res == s7_nil(sc)) {
+    fprintf(stderr, "can't load %s.\n", name);
+    abort();
+  }
+}
+
+static s7_scheme* s7 = 0;
+
+// everything s7 mallocs, so it can be told apart from our own memory
+static SizeClassPool s7_memory;
+
+// pod pools give blocks back after staying mostly free for ~5s at 60fps
+static TrimPolicy pool_trim_policy;
+
+static int vec2_type_tag = 0;
+static u64 vec2s_made = 0;    // their cells are all there is, so live ones can't be counted
+
+// vec2 is stored directly in the c-object's value field (no pool, no free
+// hook), so a vec2 costs exactly one s7 cell.
+static_assert(sizeof(Vec2) <= sizeof(void*), "Vec2 must fit into c-object value");
+
+static bool is_vec2(s7_pointer o)
+{
+  return s7_is_c_object(o) && s7_c_object_type(o) == vec2_type_tag;
+}
+
+static inline Vec2* vec2_value(s7_pointer o)
+{
+  return (Vec2*)s7_c_object_inline_value(o);
+}
+
+static s7_pointer make_vec2(s7_scheme* sc, f32 x, f32 y)
+{
+  Vec2 v = {x, y};
+  void* value = 0;
+  memcpy(&value, &v, sizeof(v));
+  vec2s_made++;
+  return s7_make_c_object_without_gc(sc, vec2_type_tag, value);
+}
+
+template <>
+struct Arg<Vec2*>
+{
+  static bool is(s7_pointer p) { return is_vec2(p); }
+  static Vec2* get(s7_scheme*, s7_pointer p) { return vec2_value(p); }
+  static const char* type_name() { return "vec2"; }
+  static const char* predicate() { return "vec2?"; }
+};
+
+template <>
+struct Ret<Vec2>
+{
+  static s7_pointer make(s7_scheme* sc, const Vec2& v) { return make_vec2(sc, v.x, v.y); }
+  static const char* predicate() { return "vec2?"; }
+};
+
+static s7_pointer vec2_to_string(s7_scheme* sc, s7_pointer args)
+{
+  s7_pointer o = s7_car(args);
+  if (!is_vec2(o)) {
+    return s7_wrong_type_arg_error(sc, "vec2 to string", 1, o, "vec2");
+  }
+  const Vec2* v = vec2_value(o);
+  char buf[256];
+  snprintf(buf, sizeof(buf), "<vec2 %.4f %.4f>", v->x, v->y);
+  return s7_make_string(sc, buf);
+}
+
+// equal? compares coordinates exactly and hashes agree with it (-0 and 0
+// are the same key); equivalent? uses the fuzzy Vec2 == from misc.h.
+static s7_pointer vec2_is_equal(s7_scheme* sc, s7_pointer args)
+{
+  s7_pointer a = s7_car(args), b = s7_cadr(args);
+  if (!is_vec2(a) || !is_vec2(b)) {
+    return s7_f(sc);
+  }
+  const Vec2* va = vec2_value(a);
+  const Vec2* vb = vec2_value(b);
+  return s7_make_boolean(sc, va->x == vb->x && va->y == vb->y);
+}
+
+static s7_pointer vec2_is_equivalent(s7_scheme* sc, s7_pointer args)
+{
+  s7_pointer a = s7_car(args), b = s7_cadr(args);
+  if (!is_vec2(a) || !is_vec2(b)) {
+    return s7_f(sc);
+  }
+  return s7_make_boolean(sc, *vec2_value(a) == *vec2_value(b));
+}
+
+static s7_int vec2_hash(s7_scheme*, s7_pointer o)
+{
+  const Vec2* v = vec2_value(o);
+  f32 x = v->x + 0.0f, y = v->y + 0.0f;    // -0 -> 0
+  u32 hx, hy;
+  memcpy(&hx, &x, sizeof(hx));
+  memcpy(&hy, &y, sizeof(hy));
+  u64 h = ((u64)hx << 32 | hy) * 0x9e3779b97f4a7c15ull;
+  h ^= h >> 31;
+  return (s7_int)(h >> 1);
+}
+
+static Vec2 vec2_new(f32 x, f32 y)
+{
+  return vec2(x, y);
+}
+
+static bool vec2p(s7_pointer o)
+{
+  return is_vec2(o);
+}
+
+static f32 vec2_x(Vec2* v)
+{
+  return v->x;
+}
+
+static void set_vec2_x(Ref<Vec2> v, f32 f)
+{
+  v->x = f;
+}
+
+static f32 vec2_y(Vec2* v)
+{
+  return v->y;
+}
+
+static void set_vec2_y(Ref<Vec2> v, f32 f)
+{
+  v->y = f;
+}
+
+static Vec2 vec2_plus(Vec2* a, Vec2* b)
+{
+  return *a + *b;
+}
+
+static Vec2 vec2_minus(Vec2* a, Vec2* b)
+{
+  return *a - *b;
+}
+
+static Vec2 vec2_mult(Vec2* a, f32 s)
+{
+  return *a * s;
+}
+
+static Vec2 vec2_div(Vec2* a, f32 s)
+{
+  return *a / s;
+}
+
+// In-place variants write into their first argument and return it, so
+// update loops like pos += vel * dt run without allocating.
+
+static Ref<Vec2> vec2_plus_x(Ref<Vec2> a, Vec2* b)
+{
+  *a = *a + *b;
+  return a;
+}
+
+static Ref<Vec2> vec2_minus_x(Ref<Vec2> a, Vec2* b)
+{
+  *a = *a - *b;
+  return a;
+}
+
+static Ref<Vec2> vec2_mult_x(Ref<Vec2> a, f32 s)
+{
+  *a = *a * s;
+  return a;
+}
+
+static Ref<Vec2> vec2_div_x(Ref<Vec2> a, f32 s)
+{
+  *a = *a / s;
+  return a;
+}
+
+// a += b * s
+static Ref<Vec2> vec2_madd_x(Ref<Vec2> a, Vec2* b, f32 s)
+{
+  *a = *a + *b * s;
+  return a;
+}
+
+static Ref<Vec2> vec2_lerp_x(Ref<Vec2> a, Vec2* b, f32 t)
+{
+  *a = lerp(*a, *b, t);
+  return a;
+}
+
+static Vec2 vec2_negate(Vec2* a)
+{
+  return -*a;
+}
+
+static bool vec2_equal(Vec2* a, Vec2* b)
+{
+  return *a == *b;
+}
+
+static f32 vec2_dot(Vec2* a, Vec2* b)
+{
+  return dot(*a, *b);
+}
+
+static f32 vec2_cross(Vec2* a, Vec2* b)
+{
+  return cross(*a, *b);
+}
+
+static f32 vec2_length(Vec2* a)
+{
+  return length(*a);
+}
+
+static f32 vec2_length2(Vec2* a)
+{
+  return length2(*a);
+}
+
+static bool vec2_is_normalized(Vec2* a)
+{
+  return is_normalized(*a);
+}
+
+static Vec2 vec2_normalized(Vec2* a)
+{
+  return normalized(*a);
+}
+
+static Vec2 vec2_perp(Vec2* a)
+{
+  return perp(*a);
+}
+
+static Vec2 vec2_rotate(Vec2* a, f32 angle)
+{
+  return rotate(*a, angle);
+}
+
+static f32 vec2_distance(Vec2* a, Vec2* b)
+{
+  return distance(*a, *b);
+}
+
+static f32 vec2_distance2(Vec2* a, Vec2* b)
+{
+  return distance2(*a, *b);
+}
+
+static Vec2 vec2_lerp(Vec2* a, Vec2* b, f32 t)
+{
+  return lerp(*a, *b, t);
+}
+
+static void check_unit_interval(const char* caller, int argi, f32 t)
+{
+  if (!(t >= 0 && t <= 1)) {
+    s7_out_of_range_error(s7, caller, argi, s7_make_real(s7, t), "a number between 0 and 1");
+  }
+}
+
+static Vec2 vec2_bezier4(Vec2* p0, Vec2* p1, Vec2* p2, Vec2* p3, f32 t)
+{
+  check_unit_interval("vec2-bezier4", 5, t);
+  return bezier4(*p0, *p1, *p2, *p3, t);
+}
+
+static Vec2 vec2_bezier4_tangent(Vec2* p0, Vec2* p1, Vec2* p2, Vec2* p3, f32 t)
+{
+  check_unit_interval("vec2-bezier4-tangent", 5, t);
+  return bezier4_tangent(*p0, *p1, *p2, *p3, t);
+}
+
+// #v(x y), read by the *#readers* entry in main.scm. The vec2 is built once
+// at read time and is immutable, so code can share it freely.
+static s7_pointer vec2_literal(s7_pointer lst)
+{
+  if (!s7_is_pair(lst) || s7_list_length(s7, lst) != 2 || !s7_is_real(s7_car(lst)) ||
+      !s7_is_real(s7_cadr(lst))) {
+    return s7_wrong_type_arg_error(s7, "#v", 1, lst, "a list of two real numbers");
+  }
+  s7_pointer v = make_vec2(s7, (f32)s7_real(s7_car(lst)), (f32)s7_real(s7_cadr(lst)));
+  return s7_immutable(v);
+}
+
+template <>
+struct Arg<Vec3*> : PodArg<Vec3>
+{
+};
+
+template <>
+struct Ret<Vec3> : PodRet<Vec3>
+{
+};
+
+template <>
+struct Arg<Vec4*> : PodArg<Vec4>
+{
+};
+
+template <>
+struct Ret<Vec4> : PodRet<Vec4>
+{
+};
+
+template <>
+struct Arg<Mat2x3*> : PodArg<Mat2x3>
+{
+};
+
+template <>
+struct Ret<Mat2x3> : PodRet<Mat2x3>
+{
+};
+
+template <>
+struct Arg<Rect*> : PodArg<Rect>
+{
+};
+
+template <>
+struct Ret<Rect> : PodRet<Rect>
+{
+};
+
+template <>
+struct Arg<Color*> : PodArg<Color>
+{
+};
+
+template <>
+struct Ret<Color> : PodRet<Color>
+{
+};
+
+static Vec3 vec3_plus(Vec3* a, Vec3* b)
+{
+  return *a + *b;
+}
+
+static Vec3 vec3_minus(Vec3* a, Vec3* b)
+{
+  return *a - *b;
+}
+
+static Vec3 vec3_mult(Vec3* a, f32 s)
+{
+  return *a * s;
+}
+
+static f32 vec3_dot(Vec3* a, Vec3* b)
+{
+  return dot(*a, *b);
+}
+
+static Vec3 vec3_cross(Vec3* a, Vec3* b)
+{
+  return cross(*a, *b);
+}
+
+static f32 vec3_length(Vec3* a)
+{
+  return length(*a);
+}
+
+static Vec4 vec4_plus(Vec4* a, Vec4* b)
+{
+  return *a + *b;
+}
+
+static Vec4 vec4_minus(Vec4* a, Vec4* b)
+{
+  return *a - *b;
+}
+
+static Vec4 vec4_mult(Vec4* a, f32 s)
+{
+  return *a * s;
+}
+
+static f32 vec4_dot(Vec4* a, Vec4* b)
+{
+  return dot(*a, *b);
+}
+
+static Mat2x3 mat2x3_mult(Mat2x3* m, Mat2x3* n)
+{
+  return *m * *n;
+}
+
+static Vec2 mat2x3_transform(Mat2x3* m, Vec2* p)
+{
+  return transform(*m, *p);
+}
+
+static bool rect_contains(Rect* r, Vec2* p)
+{
+  return contains(*r, *p);
+}
+
+static bool rect_intersects(Rect* a, Rect* b)
+{
+  return intersects(*a, *b);
+}
+
+static Color color_lerp(Color* a, Color* b, f32 t)
+{
+  return lerp(*a, *b, t);
+}
+
+static void frame_temporaries_begin()
+{
+  frame_temporaries().depth++;
+}
+
+static void frame_temporaries_end()
+{
+  FrameTemporaries& ft = frame_temporaries();
+  if (ft.depth == 0) {
+    s7_error(s7, s7_make_symbol(s7, "frame-temporaries"),
+             s7_list(s7, 1, s7_make_string(s7, "frame-temporaries-end without frame-temporaries-begin")));
+  }
+  ft.depth--;
+}
+
+// (with-frame-temporaries body ...): the expansion holds begin and end
+// themselves rather than names, so nothing else can call them and
+// unbalance depth
+static void define_with_frame_temporaries()
+{
+  s7_pointer fns = s7_inlet(
+    s7, s7_list(s7, 4, s7_make_symbol(s7, "begin-temps"),
+                make_function<BIND(frame_temporaries_begin)>(s7, "frame-temporaries-begin"),
+                s7_make_symbol(s7, "end-temps"), make_function<BIND(frame_temporaries_end)>(s7, "frame-temporaries-end")));
+  s7_eval_c_string_with_environment(s7,
+                                    "(eval `(define-expansion (with-frame-temporaries . body)"
+                                    "         (list 'dynamic-wind ,begin-temps (cons 'lambda (cons () body)) ,end-temps))"
+                                    "      (rootlet))",
+                                    fns);
+}
+
+// Counters sampled after every frame. (stats-report) prints the totals
+// with the last frame's deltas, plus the worst frame since the previous
+// report, so an allocation regression shows up one frame after it starts.
+struct StatsSample
+{
+  s7_heap_stats heap;
+  u64 cells_made;    // freed by GCs plus live; explicitly freed cells are missed
+  u64 vec2s_made;
+  u64 s7_bytes;
+  std::vector<PoolStats> pods;    // as in pod_pools()
+};
+
+struct FrameStats
+{
+  StatsSample previous;
+  StatsSample current;
+  u64 frames = 0;
+  f64 frame_ms = 0;
+  f64 max_frame_ms = 0;    // since the last report
+  u64 max_frame_cells = 0;
+
+  static void sample(StatsSample& s)
+  {
+    s7_get_heap_stats(s7, &s.heap);
+    s.cells_made = s.heap.gc_total_freed + s.heap.heap_size - s.heap.free_cells;
+    s.vec2s_made = vec2s_made;
+    s.s7_bytes = s7_memory.bytes_in_use();
+    const std::vector<PodPool>& pools = pod_pools();
+    s.pods.resize(pools.size());
+    for (u32 i = 0; i < pools.size(); i++) {
+      s.pods[i] = pools[i].stats();
+    }
+  }
+
+  void end_frame(f64 ms)
+  {
+    std::swap(previous, current);
+    sample(current);
+    if (frames++ == 0) {
+      previous = current;
+    }
+    frame_ms = ms;
+    max_frame_ms = std::max(max_frame_ms, ms);
+    max_frame_cells = std::max(max_frame_cells, current.cells_made - previous.cells_made);
+  }
+};
+
+static FrameStats frame_stats;
+
+static void appendf(std::string& out, const char* format, ...)
+{
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  out += buf;
+}
+
+// 1234 -> "1.2k" etc.
+static std::string amount(f64 n)
+{
+  const char* units[] = {"", "k", "M", "G"};
+  u32 u = 0;
+  while (fabs(n) >= 1000 && u < 3) {
+    n /= 1000;
+    u++;
+  }
+  char buf[32];
+  snprintf(buf, sizeof(buf), u ? "%.1f%s" : "%.0f%s", n, units[u]);
+  return buf;
+}
+
+static void stats_report()
+{
+  const FrameStats& fs = frame_stats;
+  const StatsSample& c = fs.current;
+  const StatsSample& p = fs.previous;
+  std::string r;
+  appendf(r, "frame %llu  %.2fms (max %.2f)\n", (unsigned long long)fs.frames, fs.frame_ms,
+          fs.max_frame_ms);
+  appendf(r, "cells   +%s (max %s)  live %s of %s  gc %lld +%lld  %.3fs\n",
+          amount(c.cells_made - p.cells_made).c_str(), amount(fs.max_frame_cells).c_str(),
+          amount(c.heap.heap_size - c.heap.free_cells).c_str(), amount(c.heap.heap_size).c_str(),
+          (long long)c.heap.gc_calls, (long long)(c.heap.gc_calls - p.heap.gc_calls),
+          c.heap.gc_total_time);
+  const f64 s7_delta = f64(c.s7_bytes) - f64(p.s7_bytes);
+  appendf(r, "s7 mem  %sB %s%sB  peak %sB  reserved %sB\n", amount(c.s7_bytes).c_str(),
+          s7_delta < 0 ? "" : "+", amount(s7_delta).c_str(),
+          amount(s7_memory.peak_bytes_in_use()).c_str(), amount(s7_memory.bytes_reserved()).c_str());
+  appendf(r, "vec2    +%s\n", amount(c.vec2s_made - p.vec2s_made).c_str());
+  appendf(r, "temps   %u of %u chunks\n", frame_temporaries().chunks_in_use(),
+          FrameTemporaries::CHUNKS);
+  const std::vector<PodPool>& pools = pod_pools();
+  for (u32 i = 0; i < c.pods.size() && i < p.pods.size(); i++) {
+    const PoolStats& a = c.pods[i];
+    const PoolStats& b = p.pods[i];
+    appendf(r, "%-7s live %s hw %s  +%s -%s  blocks %u\n", pools[i].name, amount(a.live).c_str(),
+            amount(a.high_water).c_str(), amount(a.allocations - b.allocations).c_str(),
+            amount(a.frees - b.frees).c_str(), a.blocks);
+  }
+  s7_display(s7, s7_make_string(s7, r.c_str()), s7_current_output_port(s7));
+  frame_stats.max_frame_ms = 0;
+  frame_stats.max_frame_cells = 0;
+}
+
+static f32 rnd_range(f32 a, f32 b)
+{
+  if (b < a) {
+    std::swap(a, b);
+  }
+  return ::rnd01() * (b - a) + a;
+}
+
+// Independent random streams, so a subsystem or a replay owns its
+// sequence: (make-rng seed), (rng-next r), (rng-split! r), and
+// (rng-snapshot r) / (rng-restore! r snapshot) to rewind.
+static int rng_type_tag = 0;
+static PoolAllocator<Rng> rng_pool(256);
+
+static bool is_rng(s7_pointer o)
+{
+  return s7_is_c_object(o) && s7_c_object_type(o) == rng_type_tag;
+}
+
+template <>
+struct Arg<Rng*>
+{
+  static bool is(s7_pointer p) { return is_rng(p); }
+  static Rng* get(s7_scheme*, s7_pointer p) { return (Rng*)s7_c_object_value(p); }
+  static const char* type_name() { return "rng"; }
+  static const char* predicate() { return "rng?"; }
+};
+
+template <>
+struct Ret<Rng>
+{
+  static s7_pointer make(s7_scheme* sc, const Rng& r)
+  {
+    Rng* p = rng_pool.allocate();
+    *p = r;
+    return s7_make_c_object(sc, rng_type_tag, p);
+  }
+  static const char* predicate() { return "rng?"; }
+};
+
+static void free_rng(void* val)
+{
+  rng_pool.free((Rng*)val);
+}
+
+static s7_pointer rng_to_string(s7_scheme* sc, s7_pointer args)
+{
+  s7_pointer o = s7_car(args);
+  if (!is_rng(o)) {
+    return s7_wrong_type_arg_error(sc, "rng to string", 1, o, "rng");
+  }
+  const Rng* r = (Rng*)s7_c_object_value(o);
+  char buf[64];
+  snprintf(buf, sizeof(buf), "<rng %08x%08x%08x%08x>", r->s[0], r->s[1], r->s[2], r->s[3]);
+  return s7_make_string(sc, buf);
+}
+
+static s7_pointer rng_is_equal(s7_scheme* sc, s7_pointer args)
+{
+  s7_pointer a = s7_car(args), b = s7_cadr(args);
+  return s7_make_boolean(sc, is_rng(a) && is_rng(b) &&
+                               *(Rng*)s7_c_object_value(a) == *(Rng*)s7_c_object_value(b));
+}
+
+static Rng make_rng(i32 seed)
+{
+  return Rng::seeded(u64(i64(seed)));
+}
+
+static bool rngp(s7_pointer o)
+{
+  return is_rng(o);
+}
+
+static f32 rng_next(Ref<Rng> r)
+{
+  return r->next01();
+}
+
+static f32 rng_range(Ref<Rng> r, f32 a, f32 b)
+{
+  return a + r->next01() * (b - a);
+}
+
+static i32 rng_integer(Ref<Rng> r, i32 n)
+{
+  if (n <= 0) {
+    s7_out_of_range_error(s7, "rng-integer", 2, s7_make_integer(s7, n), "a positive integer");
+  }
+  return i32(r->below(u32(n)));
+}
+
+// r keeps going from 2^64 numbers ahead; the new stream takes over r's
+// current sequence
+static Rng rng_split(Ref<Rng> r)
+{
+  return r->split();
+}
+
+static Ref<Rng> rng_jump(Ref<Rng> r)
+{
+  r->jump();
+  return r;
+}
+
+static Ref<Rng> rng_long_jump(Ref<Rng> r)
+{
+  r->long_jump();
+  return r;
+}
+
+static Rng rng_snapshot(Rng* r)
+{
+  return *r;
+}
+
+static Ref<Rng> rng_restore(Ref<Rng> r, Rng* snapshot)
+{
+  *r = *snapshot;
+  return r;
+}
+
+static int vec2_buffer_type_tag = 0;
+
+static bool is_vec2_buffer(s7_pointer o)
+{
+  return s7_is_c_object(o) && s7_c_object_type(o) == vec2_buffer_type_tag;
+}
+
+template <>
+struct Arg<Vec2Buffer*>
+{
+  static bool is(s7_pointer p) { return is_vec2_buffer(p); }
+  static Vec2Buffer* get(s7_scheme*, s7_pointer p) { return (Vec2Buffer*)s7_c_object_value(p); }
+  static const char* type_name() { return "vec2-buffer"; }
+  static const char* predicate() { return "vec2-buffer?"; }
+};
+
+static void free_vec2_buffer(void* val)
+{
+  delete (Vec2Buffer*)val;
+}
+
+static s7_pointer vec2_buffer_to_string(s7_scheme* sc, s7_pointer args)
+{
+  s7_pointer o = s7_car(args);
+  if (!is_vec2_buffer(o)) {
+    return s7_wrong_type_arg_error(sc, "vec2-buffer to string", 1, o, "vec2-buffer");
+  }
+  char buf[64];
+  snprintf(buf, sizeof(buf), "<vec2-buffer %u>", ((Vec2Buffer*)s7_c_object_value(o))->size());
+  return s7_make_string(sc, buf);
+}
+
+static s7_pointer vec2_buffer_length_hook(s7_scheme* sc, s7_pointer args)
+{
+  return s7_make_integer(sc, ((Vec2Buffer*)s7_c_object_value(s7_car(args)))->size());
+}
+
+static void check_same_size(const char* caller, const Vec2Buffer& a, const Ref<Vec2Buffer>& b)
+{
+  if (a.size() != b->size()) {
+    s7_out_of_range_error(s7, caller, 2, b.obj, "a vec2-buffer of the same length");
+  }
+}
+
+static void check_index(const char* caller, const Vec2Buffer& b, i32 i)
+{
+  if (i < 0 || (u32)i >= b.size()) {
+    s7_out_of_range_error(s7, caller, 2, s7_make_integer(s7, i), "a valid index");
+  }
+}
+
+static void check_output(const char* caller, int argi, const Vec2Buffer& b, const FloatVector& out)
+{
+  if (out.size < (s7_int)b.size()) {
+    s7_out_of_range_error(s7, caller, argi, out.obj, "a float-vector at least as long as the buffer");
+  }
+}
+
+static s7_pointer make_vec2_buffer(i32 n)
+{
+  if (n < 0) {
+    return s7_out_of_range_error(s7, "make-vec2-buffer", 1, s7_make_integer(s7, n), "a non-negative size");
+  }
+  return s7_make_c_object(s7, vec2_buffer_type_tag, new Vec2Buffer(n));
+}
 
-static sts_net_set_t set;
-static sts_net_socket_t server;
-static sts_net_socket_t clients[STS_NET_SET_SOCKETS];
+static bool vec2_bufferp(s7_pointer o)
+{
+  return is_vec2_buffer(o);
+}
 
-static PoolAllocator<Vec2>* vec2_pool = 0;
+static i32 vec2_buffer_length(Vec2Buffer* b)
+{
+  return b->size();
+}
 
-static void panic(const char* msg)
+static Vec2 vec2_buffer_ref(Vec2Buffer* b, i32 i)
 {
-  fprintf(stderr, "PANIC: %s\n\n", msg);
-  abort();
+  check_index("vec2-buffer-ref", *b, i);
+  return b->get(i);
 }
 
-static void load_script(s7_scheme* sc, const char* name)
+static void set_vec2_buffer_ref(Ref<Vec2Buffer> b, i32 i, Vec2* v)
 {
-  s7_pointer res = s7_load(sc, name);
-  if (res == s7_nil(sc)) {
-    fprintf(stderr, "can't load %s.\n", name);
-    abort();
-  }
+  check_index("vec2-buffer-ref", *b, i);
+  b->set(i, *v);
 }
 
-static int vec2_type_tag = 0;
+static Ref<Vec2Buffer> vec2_buffer_fill(Ref<Vec2Buffer> b, Vec2* v)
+{
+  fill(*b, *v);
+  return b;
+}
 
-static bool is_vec2(s7_pointer o)
+static Ref<Vec2Buffer> vec2_buffer_add(Ref<Vec2Buffer> dst, Ref<Vec2Buffer> src)
 {
-  return s7_is_c_object(o) && s7_c_object_type(o) == vec2_type_tag;
+  check_same_size("vec2-buffer-add!", *dst, src);
+  add(*dst, *src);
+  return dst;
 }
 
-static s7_pointer parse_args(s7_scheme* sc, const char* caller, s7_pointer args, const char* format, ...)
-{
-  va_list va;
-  va_start(va, format);
-  const char* p = format;
-  s7_pointer retval = 0;
-  int argi = 1;
-  while (*p && retval == 0) {
-    s7_pointer arg = s7_car(args);
-    args = s7_cdr(args);
-    switch (*p) {
-    case 'f':
-      if (s7_is_number(arg)) {
-        f32* tmp = va_arg(va, f32*);
-        *tmp = (f32)s7_number_to_real(sc, arg);
-      } else {
-        retval = s7_wrong_type_arg_error(sc, caller, argi, arg, "number");
-      }
-      break;
-    case 'i':
-      if (s7_is_integer(arg)) {
-        i32* tmp = va_arg(va, i32*);
-        *tmp = (i32)s7_integer(arg);
-      } else {
-        retval = s7_wrong_type_arg_error(sc, caller, argi, arg, "integer");
-      }
-      break;
-    case 's':
-      if (s7_is_string(arg)) {
-        const char** tmp = va_arg(va, const char**);
-        *tmp = s7_string(arg);
-      } else {
-        retval = s7_wrong_type_arg_error(sc, caller, argi, arg, "string");
-      }
-      break;
-    case 'v':
-      if (is_vec2(arg)) {
-        Vec2** tmp = va_arg(va, Vec2**);
-        *tmp = (Vec2*)s7_c_object_value(arg);
-      } else {
-        retval = s7_wrong_type_arg_error(sc, caller, argi, arg, "vec2");
-      }
-      break;
-    default: {
-      char buf[128];
-      sprintf(buf, "undefined parse_args() token: \'%c\'", *p);
-      retval = s7_wrong_type_arg_error(sc, caller, argi, arg, buf);
-    } break;
-    }
-    p++;
-    argi++;
+static Ref<Vec2Buffer> vec2_buffer_scale(Ref<Vec2Buffer> dst, f32 s)
+{
+  scale(*dst, s);
+  return dst;
+}
+
+static Ref<Vec2Buffer> vec2_buffer_madd(Ref<Vec2Buffer> dst, Ref<Vec2Buffer> src, f32 s)
+{
+  check_same_size("vec2-buffer-madd!", *dst, src);
+  madd(*dst, *src, s);
+  return dst;
+}
+
+static Ref<Vec2Buffer> vec2_buffer_normalize(Ref<Vec2Buffer> dst)
+{
+  normalize(*dst);
+  return dst;
+}
+
+static Ref<Vec2Buffer> vec2_buffer_rotate(Ref<Vec2Buffer> dst, f32 angle)
+{
+  rotate(*dst, angle);
+  return dst;
+}
+
+static Ref<Vec2Buffer> vec2_buffer_lerp(Ref<Vec2Buffer> dst, Ref<Vec2Buffer> src, f32 t)
+{
+  check_same_size("vec2-buffer-lerp!", *dst, src);
+  lerp(*dst, *src, t);
+  return dst;
+}
+
+static Ref<Vec2Buffer> vec2_buffer_clamp(Ref<Vec2Buffer> dst, Vec2* min, Vec2* max)
+{
+  clamp(*dst, *min, *max);
+  return dst;
+}
+
+static FloatVector vec2_buffer_lengths(Vec2Buffer* b, FloatVector out)
+{
+  check_output("vec2-buffer-lengths", 2, *b, out);
+  lengths(*b, out.data);
+  return out;
+}
+
+static FloatVector vec2_buffer_dots(Vec2Buffer* b, Vec2* v, FloatVector out)
+{
+  check_output("vec2-buffer-dots", 3, *b, out);
+  dots(*b, *v, out.data);
+  return out;
+}
+
+// Bulk random fills: one native call instead of one (rnd) per number.
+// Disc and circle samples go into a float-vector as x y pairs.
+
+static void check_pairs(const char* caller, const FloatVector& v)
+{
+  if (v.size % 2) {
+    s7_out_of_range_error(s7, caller, 1, v.obj, "a float-vector of x y pairs (even length)");
   }
-  va_end(va);
-  return retval;
 }
 
-static s7_pointer vec2_to_string(s7_scheme* sc, s7_pointer args)
+static FloatVector float_vector_random(FloatVector v, Ref<Rng> r, f32 lo, f32 hi)
+{
+  random_uniform(*r, v.data, v.size, lo, hi);
+  return v;
+}
+
+static FloatVector float_vector_random_normal(FloatVector v, Ref<Rng> r, f32 mean, f32 sd)
+{
+  random_normal(*r, v.data, v.size, mean, sd);
+  return v;
+}
+
+static FloatVector float_vector_random_disc(FloatVector v, Ref<Rng> r, Vec2* center, f32 radius)
+{
+  check_pairs("float-vector-random-disc!", v);
+  random_disc(*r, v.data, v.data + 1, 2, v.size / 2, center->x, center->y, radius);
+  return v;
+}
+
+static FloatVector float_vector_random_circle(FloatVector v, Ref<Rng> r, Vec2* center, f32 radius)
+{
+  check_pairs("float-vector-random-circle!", v);
+  random_circle(*r, v.data, v.data + 1, 2, v.size / 2, center->x, center->y, radius);
+  return v;
+}
+
+static Ref<Vec2Buffer> vec2_buffer_random(Ref<Vec2Buffer> b, Ref<Rng> r, Vec2* min, Vec2* max)
+{
+  random_uniform(*r, b->xs.data(), b->size(), min->x, max->x);
+  random_uniform(*r, b->ys.data(), b->size(), min->y, max->y);
+  return b;
+}
+
+static Ref<Vec2Buffer> vec2_buffer_random_normal(Ref<Vec2Buffer> b, Ref<Rng> r, Vec2* mean, f32 sd)
+{
+  random_normal(*r, b->xs.data(), b->size(), mean->x, sd);
+  random_normal(*r, b->ys.data(), b->size(), mean->y, sd);
+  return b;
+}
+
+static Ref<Vec2Buffer> vec2_buffer_random_disc(Ref<Vec2Buffer> b, Ref<Rng> r, Vec2* center, f32 radius)
+{
+  random_disc(*r, b->xs.data(), b->ys.data(), 1, b->size(), center->x, center->y, radius);
+  return b;
+}
+
+static Ref<Vec2Buffer> vec2_buffer_random_circle(Ref<Vec2Buffer> b, Ref<Rng> r, Vec2* center, f32 radius)
+{
+  random_circle(*r, b->xs.data(), b->ys.data(), 1, b->size(), center->x, center->y, radius);
+  return b;
+}
+
+// A bezier curve prepared for path following: entities store the distance
+// they have travelled and turn it into a position with bezier-t-at and
+// bezier-positions!, one call for all of them.
+
+static int bezier_type_tag = 0;
+
+static bool is_bezier(s7_pointer o)
 {
-  Vec2* v;
-  if (auto err = parse_args(sc, "vec2 to string", args, "v", &v)) {
-    return err;
+  return s7_is_c_object(o) && s7_c_object_type(o) == bezier_type_tag;
+}
+
+template <>
+struct Arg<BezierCurve*>
+{
+  static bool is(s7_pointer p) { return is_bezier(p); }
+  static BezierCurve* get(s7_scheme*, s7_pointer p) { return (BezierCurve*)s7_c_object_value(p); }
+  static const char* type_name() { return "bezier"; }
+  static const char* predicate() { return "bezier?"; }
+};
+
+static void free_bezier(void* val)
+{
+  delete (BezierCurve*)val;
+}
+
+static s7_pointer bezier_to_string(s7_scheme* sc, s7_pointer args)
+{
+  s7_pointer o = s7_car(args);
+  if (!is_bezier(o)) {
+    return s7_wrong_type_arg_error(sc, "bezier to string", 1, o, "bezier");
   }
-  char buf[256];
-  snprintf(buf, sizeof(buf), "<vec2 %.4f %.4f>", v->x, v->y);
+  char buf[64];
+  snprintf(buf, sizeof(buf), "<bezier length %g>", ((BezierCurve*)s7_c_object_value(o))->length());
   return s7_make_string(sc, buf);
 }
 
-static inline void free_vec2(void* val)
+static void check_samples(const char* caller, const FloatVector& in, const FloatVector& out, s7_int per_sample)
 {
-  if (val) {
-    // printf("freeing Vec2\n");
-    vec2_pool->free((Vec2*)val);
+  if (out.size < in.size * per_sample) {
+    s7_out_of_range_error(s7, caller, 3, out.obj,
+                          per_sample == 1 ? "a float-vector at least as long as the input"
+                                          : "a float-vector with room for an x y pair per input");
   }
 }
 
-static bool equal_vec2(void* val1, void* val2)
+static s7_pointer make_bezier(Vec2* p0, Vec2* p1, Vec2* p2, Vec2* p3)
 {
-  return val1 == val2;
+  return s7_make_c_object(s7, bezier_type_tag, new BezierCurve(*p0, *p1, *p2, *p3));
 }
 
-static s7_pointer vec2(s7_scheme* sc, s7_pointer args)
+static bool bezierp(s7_pointer o)
 {
-  f32 x, y;
-  if (auto err = parse_args(sc, "vec2", args, "ff", &x, &y)) {
-    return err;
-  }
-  Vec2* o = vec2_pool->allocate();
-  o->x = x;
-  o->y = y;
-  return s7_make_c_object(sc, vec2_type_tag, (void*)o);
+  return is_bezier(o);
+}
+
+static f32 bezier_length(BezierCurve* c)
+{
+  return c->length();
+}
+
+static f32 bezier_t_at(BezierCurve* c, f32 distance)
+{
+  return c->t_at(distance);
+}
+
+static Vec2 bezier_position(BezierCurve* c, f32 t)
+{
+  return c->position(t);
+}
+
+static Vec2 bezier_tangent(BezierCurve* c, f32 t)
+{
+  return c->tangent(t);
+}
+
+static FloatVector bezier_ts_at(BezierCurve* c, FloatVector distances, FloatVector out)
+{
+  check_samples("bezier-ts-at!", distances, out, 1);
+  ts_at(*c, distances.data, distances.size, out.data);
+  return out;
+}
+
+static FloatVector bezier_positions(BezierCurve* c, FloatVector ts, FloatVector out)
+{
+  check_samples("bezier-positions!", ts, out, 2);
+  positions(*c, ts.data, ts.size, out.data);
+  return out;
 }
 
-static s7_pointer vec2p(s7_scheme* sc, s7_pointer args)
+static FloatVector bezier_tangents(BezierCurve* c, FloatVector ts, FloatVector out)
 {
-  return s7_make_boolean(sc, is_vec2(s7_car(args)));
+  check_samples("bezier-tangents!", ts, out, 2);
+  tangents(*c, ts.data, ts.size, out.data);
+  return out;
 }
 
-static s7_pointer vec2_x(s7_scheme* sc, s7_pointer args)
+// Tweens run natively: main() advances all of them once per frame, then
+// calls the tween-call! callbacks with their values and the on-done
+// thunks of the tweens that finished, in storage order. Whatever a tween
+// refers to is gc-protected until it finishes or is killed.
+
+static Tweens tweens;
+static s7_pointer ease_symbols[EASE_COUNT];
+
+template <>
+struct Arg<Tween*> : HandleArg<Tween>
+{
+};
+
+static Ease ease_of(s7_pointer p)
 {
-  Vec2* v;
-  if (auto err = parse_args(sc, "vec2-x", args, "v", &v)) {
-    return err;
+  u32 e = 0;
+  while (e < EASE_COUNT && ease_symbols[e] != p) {
+    e++;
   }
-  return s7_make_real(sc, v->x);
+  return Ease(e);
 }
 
-static s7_pointer set_vec2_x(s7_scheme* sc, s7_pointer args)
+template <>
+struct Arg<Ease>
 {
-  Vec2* v;
-  f32 f;
-  if (auto err = parse_args(sc, "vec2-x", args, "vf", &v, &f)) {
-    return err;
+  static bool is(s7_pointer p) { return ease_of(p) != EASE_COUNT; }
+  static Ease get(s7_scheme*, s7_pointer p) { return ease_of(p); }
+  static const char* type_name()
+  {
+    return "an easing: 'linear, 'cubic-in, 'cubic-out, 'cubic-in-out, 'back-in, 'back-out, "
+           "'elastic-in, 'elastic-out, 'bounce-in or 'bounce-out";
+  }
+  static const char* predicate() { return "symbol?"; }
+};
+
+static void check_procedure(const char* caller, int argi, s7_pointer p, s7_int arity)
+{
+  if (!s7_is_procedure(p) || !s7_is_aritable(s7, p, arity)) {
+    s7_wrong_type_arg_error(s7, caller, argi, p,
+                            arity ? "a procedure of one argument" : "a procedure of no arguments");
   }
-  v->x = f;
-  return s7_undefined(sc);
 }
 
-static s7_pointer vec2_y(s7_scheme* sc, s7_pointer args)
+static void release_tween(const Tween& t)
 {
-  Vec2* v;
-  if (auto err = parse_args(sc, "vec2-y", args, "v", &v)) {
-    return err;
+  for (i64 loc : {t.keep, t.call, t.on_done}) {
+    if (loc >= 0) {
+      s7_gc_unprotect_at(s7, loc);
+    }
   }
-  return s7_make_real(sc, v->y);
 }
 
-static s7_pointer set_vec2_y(s7_scheme* sc, s7_pointer args)
+static Tween new_tween(Tween::Kind kind, Ease e)
+{
+  Tween t = {};
+  t.kind = kind;
+  t.ease = e;
+  t.keep = t.call = t.on_done = -1;
+  return t;
+}
+
+// from wherever v is when the tween starts
+static Handle<Tween> tween_vec2(Ref<Vec2> v, Vec2* to, f32 duration, Ease e)
+{
+  Tween t = new_tween(Tween::VEC2, e);
+  t.target = v.p;
+  t.to = *to;
+  t.keep = s7_gc_protect(s7, v.obj);
+  return tweens.add(t, duration, 0);
+}
+
+static Handle<Tween> tween_float_vector(FloatVector v, i32 i, f64 to, f32 duration, Ease e)
 {
-  Vec2* v;
-  f32 f;
-  if (auto err = parse_args(sc, "vec2-y", args, "vf", &v, &f)) {
-    return err;
+  if (s7_is_immutable(v.obj)) {
+    s7_wrong_type_arg_error(s7, "tween-float-vector!", 1, v.obj, "a mutable float-vector");
   }
-  v->y = f;
-  return s7_undefined(sc);
+  if (i < 0 || i >= v.size) {
+    s7_out_of_range_error(s7, "tween-float-vector!", 2, s7_make_integer(s7, i), "a valid index");
+  }
+  Tween t = new_tween(Tween::F64, e);
+  t.target = v.data + i;
+  t.to_f64 = to;
+  t.keep = s7_gc_protect(s7, v.obj);
+  return tweens.add(t, duration, 0);
+}
+
+// (f value) every frame
+static Handle<Tween> tween_call(s7_pointer f, f32 from, f32 to, f32 duration, Ease e)
+{
+  check_procedure("tween-call!", 1, f, 1);
+  Tween t = new_tween(Tween::CALL, e);
+  t.from.x = from;
+  t.to.x = to;
+  t.started = true;
+  t.call = s7_gc_protect(s7, f);
+  return tweens.add(t, duration, 0);
+}
+
+// both return the tween, for chaining
+static Handle<Tween> tween_delay(Tween* t, f32 seconds)
+{
+  if (t->elapsed > 0) {
+    s7_out_of_range_error(s7, "tween-delay!", 1, Ret<Handle<Tween>>::make(s7, tweens.handle(t)),
+                          "a tween that has not started");
+  }
+  t->elapsed = -std::max(seconds, 0.0f);
+  return tweens.handle(t);
 }
 
-static s7_pointer vec2_plus(s7_scheme* sc, s7_pointer args)
+static Handle<Tween> tween_on_done(Tween* t, s7_pointer thunk)
 {
-  Vec2 *a, *b;
-  if (auto err = parse_args(sc, "vec2+", args, "vv", &a, &b)) {
-    return err;
+  check_procedure("tween-on-done!", 2, thunk, 0);
+  if (t->on_done >= 0) {
+    s7_gc_unprotect_at(s7, t->on_done);
   }
-  Vec2* res = vec2_pool->allocate();
-  res->x = a->x + b->x;
-  res->y = a->y + b->y;
-  return s7_make_c_object(sc, vec2_type_tag, (void*)res);
+  t->on_done = s7_gc_protect(s7, thunk);
+  return tweens.handle(t);
 }
 
-static s7_pointer vec2_minus(s7_scheme* sc, s7_pointer args)
+// #f if it had already finished or been killed
+static bool tween_kill(Handle<Tween> h)
 {
-  Vec2 *a, *b;
-  if (auto err = parse_args(sc, "vec2-", args, "vv", &a, &b)) {
-    return err;
+  Tween killed;
+  if (!tweens.kill(h, &killed)) {
+    return false;
   }
-  Vec2* res = vec2_pool->allocate();
-  res->x = a->x - b->x;
-  res->y = a->y - b->y;
-  return s7_make_c_object(sc, vec2_type_tag, (void*)res);
+  release_tween(killed);
+  return true;
+}
+
+static i32 tween_count()
+{
+  return tweens.size();
 }
 
-static s7_pointer vec2_mult(s7_scheme* sc, s7_pointer args)
+// s7_call applies a c function directly, outside the error catch it sets
+// up for closures, so an error in (tween-call! car ...) would longjmp into
+// nothing; those go through a closure instead.
+static s7_pointer apply_closure = 0;
+
+static s7_pointer call_back(s7_pointer f, s7_pointer args)
 {
-  Vec2* a;
-  f32 s;
-  if (auto err = parse_args(sc, "vec2*", args, "vf", &a, &s)) {
-    return err;
+  if (s7_is_function(f)) {    // a c function
+    return s7_call(s7, apply_closure, s7_cons(s7, f, args));
   }
-  Vec2* res = vec2_pool->allocate();
-  res->x = a->x * s;
-  res->y = a->y * s;
-  return s7_make_c_object(sc, vec2_type_tag, (void*)res);
+  return s7_call(s7, f, args);
 }
 
-static s7_pointer vec2_div(s7_scheme* sc, s7_pointer args)
+static void update_tweens(f32 dt)
 {
-  Vec2* a;
-  f32 s;
-  if (auto err = parse_args(sc, "vec2/", args, "vf", &a, &s)) {
-    return err;
+  static std::vector<Tweens::Value> values;
+  static std::vector<Tween> finished;
+  values.clear();
+  finished.clear();
+  tweens.update(dt, values, finished);
+  for (const auto& v : values) {
+    // a callback may have killed a later tween
+    if (v.last || tweens.get(v.tween)) {
+      call_back(s7_gc_protected_at(s7, v.call), s7_cons(s7, s7_make_real(s7, v.value), s7_nil(s7)));
+    }
+  }
+  for (const auto& t : finished) {
+    if (t.on_done >= 0) {
+      call_back(s7_gc_protected_at(s7, t.on_done), s7_nil(s7));
+    }
   }
-  Vec2* res = vec2_pool->allocate();
-  res->x = a->x / s;
-  res->y = a->y / s;
-  return s7_make_c_object(sc, vec2_type_tag, (void*)res);
+  for (const auto& t : finished) {
+    release_tween(t);
+  }
+}
+
+// Curves baked from an easing, a procedure or spline points, sampled by
+// table lookup: curve-values! eases a whole float-vector of ts at once.
+
+static int curve_type_tag = 0;
+
+static bool is_curve(s7_pointer o)
+{
+  return s7_is_c_object(o) && s7_c_object_type(o) == curve_type_tag;
+}
+
+template <>
+struct Arg<Curve*>
+{
+  static bool is(s7_pointer p) { return is_curve(p); }
+  static Curve* get(s7_scheme*, s7_pointer p) { return (Curve*)s7_c_object_value(p); }
+  static const char* type_name() { return "curve"; }
+  static const char* predicate() { return "curve?"; }
+};
+
+static void free_curve(void* val)
+{
+  delete (Curve*)val;
 }
 
-static s7_pointer ease_linear(s7_scheme* sc, s7_pointer args)
+static s7_pointer curve_to_string(s7_scheme* sc, s7_pointer args)
 {
-  f32 t;
-  if (auto err = parse_args(sc, "ease-linear", args, "f", &t)) {
-    return err;
+  s7_pointer o = s7_car(args);
+  if (!is_curve(o)) {
+    return s7_wrong_type_arg_error(sc, "curve to string", 1, o, "curve");
   }
-  return s7_make_real(sc, ::ease_linear(t));
+  const Curve* c = (Curve*)s7_c_object_value(o);
+  char buf[64];
+  snprintf(buf, sizeof(buf), "<curve from %g to %g>", c->ys[0], c->ys[Curve::SEGMENTS]);
+  return s7_make_string(sc, buf);
+}
+
+static s7_pointer new_curve(const Curve& c)
+{
+  return s7_make_c_object(s7, curve_type_tag, new Curve(c));
+}
+
+static s7_pointer make_ease_curve(Ease e)
+{
+  return new_curve(Curve([e](f32 t) { return ease(e, t); }));
+}
+
+// calls f at each of the 1025 sample points
+static s7_pointer make_curve(s7_pointer f)
+{
+  check_procedure("make-curve", 1, f, 1);
+  // on the stack, so an error in f leaks nothing
+  return new_curve(Curve([f](f32 t) {
+    s7_pointer y = call_back(f, s7_cons(s7, s7_make_real(s7, t), s7_nil(s7)));
+    if (!s7_is_real(y)) {
+      s7_wrong_type_arg_error(s7, "make-curve", 1, f, "a procedure returning real numbers");
+    }
+    return f32(s7_real(y));
+  }));
 }
 
-static s7_pointer ease_cubic_in(s7_scheme* sc, s7_pointer args)
+static s7_pointer make_spline_curve(FloatVector points)
 {
-  f32 t;
-  if (auto err = parse_args(sc, "ease-cubic-in", args, "f", &t)) {
-    return err;
+  if (points.size < 2) {
+    s7_out_of_range_error(s7, "make-spline-curve", 1, points.obj, "at least two points");
   }
-  return s7_make_real(sc, ::ease_cubic_in(t));
+  return new_curve(Curve([&points](f32 t) { return spline_value(points.data, points.size, t); }));
+}
+
+static bool curvep(s7_pointer o)
+{
+  return is_curve(o);
+}
+
+static f32 curve_value(Curve* c, f32 t)
+{
+  return c->value(t);
+}
+
+static FloatVector curve_values(Curve* c, FloatVector ts, FloatVector out)
+{
+  check_samples("curve-values!", ts, out, 1);
+  values(*c, ts.data, ts.size, out.data);
+  return out;
+}
+
+// Circles keyed by the script's own ids, e.g. entity indices, for
+// neighbour and overlap queries that look at a few grid cells instead of
+// every entity. Queries fill an int-vector the caller keeps between
+// frames and return how many ids (or pairs) there were, which may be more
+// than fit.
+
+static int spatial_hash_type_tag = 0;
+
+static bool is_spatial_hash(s7_pointer o)
+{
+  return s7_is_c_object(o) && s7_c_object_type(o) == spatial_hash_type_tag;
 }
 
-static s7_pointer ease_cubic_out(s7_scheme* sc, s7_pointer args)
+template <>
+struct Arg<SpatialHash*>
 {
-  f32 t;
-  if (auto err = parse_args(sc, "ease-cubic-out", args, "f", &t)) {
-    return err;
+  static bool is(s7_pointer p) { return is_spatial_hash(p); }
+  static SpatialHash* get(s7_scheme*, s7_pointer p) { return (SpatialHash*)s7_c_object_value(p); }
+  static const char* type_name() { return "spatial-hash"; }
+  static const char* predicate() { return "spatial-hash?"; }
+};
+
+static void free_spatial_hash(void* val)
+{
+  delete (SpatialHash*)val;
+}
+
+static s7_pointer spatial_hash_to_string(s7_scheme* sc, s7_pointer args)
+{
+  s7_pointer o = s7_car(args);
+  if (!is_spatial_hash(o)) {
+    return s7_wrong_type_arg_error(sc, "spatial-hash to string", 1, o, "spatial-hash");
   }
-  return s7_make_real(sc, ::ease_cubic_out(t));
+  const SpatialHash* h = (SpatialHash*)s7_c_object_value(o);
+  char buf[64];
+  snprintf(buf, sizeof(buf), "<spatial-hash %u, cell %g>", h->count(), h->cell_size());
+  return s7_make_string(sc, buf);
 }
 
-static s7_pointer ease_cubic_in_out(s7_scheme* sc, s7_pointer args)
+static s7_pointer make_spatial_hash(f32 cell_size)
 {
-  f32 t;
-  if (auto err = parse_args(sc, "ease-cubic-in-out", args, "f", &t)) {
-    return err;
+  if (!(cell_size > 0 && cell_size < FLT_MAX)) {
+    s7_out_of_range_error(s7, "make-spatial-hash", 1, s7_make_real(s7, cell_size), "a positive cell size");
   }
-  return s7_make_real(sc, ::ease_cubic_in_out(t));
+  return s7_make_c_object(s7, spatial_hash_type_tag, new SpatialHash(cell_size));
 }
 
-static s7_pointer rnd01(s7_scheme* sc, s7_pointer args)
+static bool spatial_hashp(s7_pointer o)
 {
-  (void)args;
-  return s7_make_real(sc, ::rnd01());
+  return is_spatial_hash(o);
 }
 
-static s7_pointer rnd(s7_scheme* sc, s7_pointer args)
+static void check_id(const char* caller, const SpatialHash& h, i32 id, bool present)
 {
-  f32 a, b;
-  if (auto err = parse_args(sc, "rnd", args, "ff", &a, &b)) {
-    return err;
+  if (id < 0 || id >= SpatialHash::MAX_ID) {
+    s7_out_of_range_error(s7, caller, 2, s7_make_integer(s7, id), "an id between 0 and 16777215");
   }
-  if (b < a) {
-    std::swap(a, b);
+  if (h.contains(id) != present) {
+    s7_out_of_range_error(s7, caller, 2, s7_make_integer(s7, id),
+                          present ? "an id in the spatial hash" : "an id not yet in the spatial hash");
   }
-  return s7_make_real(sc, ::rnd01() * (b - a) + a);
 }
 
-static s7_scheme* s7 = 0;
+static Ref<SpatialHash> spatial_hash_insert(Ref<SpatialHash> h, i32 id, Vec2* pos, f32 radius)
+{
+  check_id("spatial-hash-insert!", *h, id, false);
+  if (!(radius >= 0)) {
+    s7_out_of_range_error(s7, "spatial-hash-insert!", 4, s7_make_real(s7, radius), "a radius >= 0");
+  }
+  h->insert(id, *pos, radius);
+  return h;
+}
+
+static Ref<SpatialHash> spatial_hash_move(Ref<SpatialHash> h, i32 id, Vec2* pos)
+{
+  check_id("spatial-hash-move!", *h, id, true);
+  h->move(id, *pos);
+  return h;
+}
+
+// ids below the buffer's length move to their positions in it
+static Ref<SpatialHash> spatial_hash_update(Ref<SpatialHash> h, Vec2Buffer* positions)
+{
+  h->move_all(positions->xs.data(), positions->ys.data(), positions->size());
+  return h;
+}
+
+static bool spatial_hash_remove(Ref<SpatialHash> h, i32 id)
+{
+  return h->remove(id);
+}
+
+static Ref<SpatialHash> spatial_hash_clear(Ref<SpatialHash> h)
+{
+  h->clear();
+  return h;
+}
+
+static i32 spatial_hash_count(SpatialHash* h)
+{
+  return h->count();
+}
+
+static bool spatial_hash_contains(SpatialHash* h, i32 id)
+{
+  return h->contains(id);
+}
+
+static i32 spatial_hash_circle(SpatialHash* h, Vec2* center, f32 radius, IntVector out)
+{
+  return h->query_circle(*center, radius, out.data, out.size);
+}
+
+static i32 spatial_hash_rect(SpatialHash* h, Rect* r, IntVector out)
+{
+  return h->query_rect(*r, out.data, out.size);
+}
+
+static i32 spatial_hash_pairs(SpatialHash* h, IntVector out)
+{
+  return h->pairs(out.data, out.size);
+}
+
+// Batch collision tests, one shape against every circle (centres in a
+// vec2-buffer, radii in a float-vector) or segment (start and end points
+// in two vec2-buffers). Hit indices go to an int-vector and times of
+// impact to a float-vector, at most as many as fit; the result is how
+// many there were in total.
+static void check_segments(const char* caller, int argi, const Vec2Buffer& starts, const Vec2Buffer& ends)
+{
+  if (ends.size() != starts.size()) {
+    s7_out_of_range_error(s7, caller, argi, s7_make_integer(s7, ends.size()),
+                          "a vec2-buffer of ends as long as the starts");
+  }
+}
+
+static i32 collide_circles_overlapping_circle(Vec2Buffer* centers, FloatVector radii, Vec2* center,
+                                              f32 radius, IntVector hits)
+{
+  check_output("circles-overlapping-circle!", 2, *centers, radii);
+  return circles_overlapping_circle(*centers, radii.data, *center, radius, hits.data, hits.size);
+}
+
+static i32 collide_circles_touching_segment(Vec2Buffer* centers, FloatVector radii, Vec2* a, Vec2* b,
+                                            IntVector hits)
+{
+  check_output("circles-touching-segment!", 2, *centers, radii);
+  return circles_touching_segment(*centers, radii.data, *a, *b, hits.data, hits.size);
+}
+
+// o + d t for t in [0, max-t]
+static i32 collide_ray_circles(Vec2* o, Vec2* d, f32 max_t, Vec2Buffer* centers, FloatVector radii,
+                               IntVector hits, FloatVector times)
+{
+  check_output("ray-circles!", 5, *centers, radii);
+  return ray_circles(*o, *d, max_t, *centers, radii.data, hits.data, times.data,
+                     std::min(hits.size, times.size));
+}
+
+// a circle of the given radius swept from o to o + d max-t
+static i32 collide_ray_segments(Vec2* o, Vec2* d, f32 radius, f32 max_t, Vec2Buffer* starts,
+                                Vec2Buffer* ends, IntVector hits, FloatVector times)
+{
+  if (radius < 0) {
+    s7_out_of_range_error(s7, "ray-segments!", 3, s7_make_real(s7, radius), "a radius >= 0");
+  }
+  check_segments("ray-segments!", 6, *starts, *ends);
+  return ray_segments(*o, *d, radius, max_t, *starts, *ends, hits.data, times.data,
+                      std::min(hits.size, times.size));
+}
 
 static void init_s7()
 {
-  s7 = s7_init();
+  s7 = s7_init_with_allocator(&s7_memory.allocator());
   load_script(s7, "write.scm");
 
-  vec2_pool = new PoolAllocator<Vec2>(16384);
-
   vec2_type_tag = s7_make_c_type(s7, "vec2");
-  s7_c_type_set_free(s7, vec2_type_tag, free_vec2);
-  s7_c_type_set_equal(s7, vec2_type_tag, equal_vec2);
+  s7_c_type_set_is_equal(s7, vec2_type_tag, vec2_is_equal);
+  s7_c_type_set_is_equivalent(s7, vec2_type_tag, vec2_is_equivalent);
+  s7_c_type_set_hash(s7, vec2_type_tag, vec2_hash);
   s7_c_type_set_to_string(s7, vec2_type_tag, vec2_to_string);
 
-  s7_define_function(s7, "vec2", vec2, 2, 0, false, 0);
-  s7_define_function(s7, "vec2?", vec2p, 1, 0, false, 0);
-  s7_define_variable(s7, "vec2-x",
-                     s7_dilambda(s7, "vec2-x", vec2_x, 1, 0, set_vec2_x, 2, 0, 0));
-  s7_define_variable(s7, "vec2-y",
-                     s7_dilambda(s7, "vec2-y", vec2_y, 1, 0, set_vec2_y, 2, 0, 0));
-  s7_define_function(s7, "vec2+", vec2_plus, 2, 0, false, 0);
-  s7_define_function(s7, "vec2-", vec2_minus, 2, 0, false, 0);
-  s7_define_function(s7, "vec2*", vec2_mult, 2, 0, false, 0);
-  s7_define_function(s7, "vec2/", vec2_div, 2, 0, false, 0);
-
-  s7_define_function(s7, "ease-linear", ease_linear, 1, 0, false, 0);
-  s7_define_function(s7, "ease-cubic-in", ease_cubic_in, 1, 0, false, 0);
-  s7_define_function(s7, "ease-cubic-out", ease_cubic_out, 1, 0, false, 0);
-  s7_define_function(s7, "ease-cubic-in-out", ease_cubic_in_out, 1, 0, false, 0);
-  s7_define_function(s7, "rnd01", rnd01, 0, 0, false, 0);
-  s7_define_function(s7, "rnd", rnd, 2, 0, false, 0);
+  define_function<BIND(vec2_new)>(s7, "vec2");
+  define_function<BIND(vec2p)>(s7, "vec2?");
+  define_function<BIND(vec2_literal)>(s7, "vec2-literal");
+  define_accessor<BIND(vec2_x), BIND(set_vec2_x)>(s7, "vec2-x");
+  define_accessor<BIND(vec2_y), BIND(set_vec2_y)>(s7, "vec2-y");
+  define_function<BIND(vec2_plus)>(s7, "vec2+");
+  define_function<BIND(vec2_minus)>(s7, "vec2-");
+  define_function<BIND(vec2_mult)>(s7, "vec2*");
+  define_function<BIND(vec2_div)>(s7, "vec2/");
+  define_function<BIND(vec2_plus_x)>(s7, "vec2+!");
+  define_function<BIND(vec2_minus_x)>(s7, "vec2-!");
+  define_function<BIND(vec2_mult_x)>(s7, "vec2*!");
+  define_function<BIND(vec2_div_x)>(s7, "vec2/!");
+  define_function<BIND(vec2_madd_x)>(s7, "vec2-madd!");
+  define_function<BIND(vec2_lerp_x)>(s7, "vec2-lerp!");
+  define_function<BIND(vec2_negate)>(s7, "vec2-negate");
+  define_function<BIND(vec2_equal)>(s7, "vec2=?");
+  define_function<BIND(vec2_dot)>(s7, "vec2-dot");
+  define_function<BIND(vec2_cross)>(s7, "vec2-cross");
+  define_function<BIND(vec2_length)>(s7, "vec2-length");
+  define_function<BIND(vec2_length2)>(s7, "vec2-length2");
+  define_function<BIND(vec2_is_normalized)>(s7, "vec2-normalized?");
+  define_function<BIND(vec2_normalized)>(s7, "vec2-normalized");
+  define_function<BIND(vec2_perp)>(s7, "vec2-perp");
+  define_function<BIND(vec2_rotate)>(s7, "vec2-rotate");
+  define_function<BIND(vec2_distance)>(s7, "vec2-distance");
+  define_function<BIND(vec2_distance2)>(s7, "vec2-distance2");
+  define_function<BIND(vec2_lerp)>(s7, "vec2-lerp");
+  define_function<BIND(vec2_bezier4)>(s7, "vec2-bezier4");
+  define_function<BIND(vec2_bezier4_tangent)>(s7, "vec2-bezier4-tangent");
+  define_function<BIND(xunit_rotated)>(s7, "xunit-rotated");
+  define_function<BIND(yunit_rotated)>(s7, "yunit-rotated");
+
+  define_pod_type<Vec3, &Vec3::x, &Vec3::y, &Vec3::z>(s7, "vec3", {"x", "y", "z"});
+  define_function<BIND(vec3_plus)>(s7, "vec3+");
+  define_function<BIND(vec3_minus)>(s7, "vec3-");
+  define_function<BIND(vec3_mult)>(s7, "vec3*");
+  define_function<BIND(vec3_dot)>(s7, "vec3-dot");
+  define_function<BIND(vec3_cross)>(s7, "vec3-cross");
+  define_function<BIND(vec3_length)>(s7, "vec3-length");
+
+  define_pod_type<Vec4, &Vec4::x, &Vec4::y, &Vec4::z, &Vec4::w>(s7, "vec4", {"x", "y", "z", "w"});
+  define_function<BIND(vec4_plus)>(s7, "vec4+");
+  define_function<BIND(vec4_minus)>(s7, "vec4-");
+  define_function<BIND(vec4_mult)>(s7, "vec4*");
+  define_function<BIND(vec4_dot)>(s7, "vec4-dot");
+
+  define_pod_type<Mat2x3, &Mat2x3::a, &Mat2x3::b, &Mat2x3::c, &Mat2x3::d, &Mat2x3::tx, &Mat2x3::ty>(
+    s7, "mat2x3", {"a", "b", "c", "d", "tx", "ty"});
+  define_function<BIND(mat2x3_identity)>(s7, "mat2x3-identity");
+  define_function<BIND(mat2x3_translation)>(s7, "mat2x3-translation");
+  define_function<BIND(mat2x3_rotation)>(s7, "mat2x3-rotation");
+  define_function<BIND(mat2x3_scaling)>(s7, "mat2x3-scaling");
+  define_function<BIND(mat2x3_mult)>(s7, "mat2x3*");
+  define_function<BIND(mat2x3_transform)>(s7, "mat2x3-transform");
+
+  define_pod_type<Rect, &Rect::x, &Rect::y, &Rect::w, &Rect::h>(s7, "rect", {"x", "y", "w", "h"});
+  define_function<BIND(rect_contains)>(s7, "rect-contains?");
+  define_function<BIND(rect_intersects)>(s7, "rect-intersects?");
+
+  define_pod_type<Color, &Color::r, &Color::g, &Color::b, &Color::a>(s7, "color", {"r", "g", "b", "a"});
+  define_function<BIND(color_lerp)>(s7, "color-lerp");
+
+  frame_temporaries().init(s7);
+  define_with_frame_temporaries();    // pod values made in body come from the frame arena
+  define_function<BIND(stats_report)>(s7, "stats-report");
+
+  vec2_buffer_type_tag = s7_make_c_type(s7, "vec2-buffer");
+  s7_c_type_set_free(s7, vec2_buffer_type_tag, free_vec2_buffer);
+  s7_c_type_set_to_string(s7, vec2_buffer_type_tag, vec2_buffer_to_string);
+  s7_c_type_set_length(s7, vec2_buffer_type_tag, vec2_buffer_length_hook);
+
+  define_function<BIND(make_vec2_buffer)>(s7, "make-vec2-buffer");
+  define_function<BIND(vec2_bufferp)>(s7, "vec2-buffer?");
+  define_function<BIND(vec2_buffer_length)>(s7, "vec2-buffer-length");
+  define_accessor<BIND(vec2_buffer_ref), BIND(set_vec2_buffer_ref)>(s7, "vec2-buffer-ref");
+  define_function<BIND(vec2_buffer_fill)>(s7, "vec2-buffer-fill!");
+  define_function<BIND(vec2_buffer_add)>(s7, "vec2-buffer-add!");
+  define_function<BIND(vec2_buffer_scale)>(s7, "vec2-buffer-scale!");
+  define_function<BIND(vec2_buffer_madd)>(s7, "vec2-buffer-madd!");
+  define_function<BIND(vec2_buffer_normalize)>(s7, "vec2-buffer-normalize!");
+  define_function<BIND(vec2_buffer_rotate)>(s7, "vec2-buffer-rotate!");
+  define_function<BIND(vec2_buffer_lerp)>(s7, "vec2-buffer-lerp!");
+  define_function<BIND(vec2_buffer_clamp)>(s7, "vec2-buffer-clamp!");
+  define_function<BIND(vec2_buffer_lengths)>(s7, "vec2-buffer-lengths");
+  define_function<BIND(vec2_buffer_dots)>(s7, "vec2-buffer-dots");
+  define_function<BIND(vec2_buffer_random)>(s7, "vec2-buffer-random!");
+  define_function<BIND(vec2_buffer_random_normal)>(s7, "vec2-buffer-random-normal!");
+  define_function<BIND(vec2_buffer_random_disc)>(s7, "vec2-buffer-random-disc!");
+  define_function<BIND(vec2_buffer_random_circle)>(s7, "vec2-buffer-random-circle!");
+
+  define_function<BIND(float_vector_random)>(s7, "float-vector-random!");
+  define_function<BIND(float_vector_random_normal)>(s7, "float-vector-random-normal!");
+  define_function<BIND(float_vector_random_disc)>(s7, "float-vector-random-disc!");
+  define_function<BIND(float_vector_random_circle)>(s7, "float-vector-random-circle!");
+
+  bezier_type_tag = s7_make_c_type(s7, "bezier");
+  s7_c_type_set_free(s7, bezier_type_tag, free_bezier);
+  s7_c_type_set_to_string(s7, bezier_type_tag, bezier_to_string);
+
+  define_function<BIND(make_bezier)>(s7, "make-bezier");
+  define_function<BIND(bezierp)>(s7, "bezier?");
+  define_function<BIND(bezier_length)>(s7, "bezier-length");
+  define_function<BIND(bezier_t_at)>(s7, "bezier-t-at");
+  define_function<BIND(bezier_position)>(s7, "bezier-position");
+  define_function<BIND(bezier_tangent)>(s7, "bezier-tangent");
+  define_function<BIND(bezier_ts_at)>(s7, "bezier-ts-at!");
+  define_function<BIND(bezier_positions)>(s7, "bezier-positions!");
+  define_function<BIND(bezier_tangents)>(s7, "bezier-tangents!");
+
+  for (u32 e = 0; e < EASE_COUNT; e++) {
+    ease_symbols[e] = s7_make_symbol(s7, ease_names[e]);
+  }
+  apply_closure = s7_eval_c_string(s7, "(lambda (f . args) (apply f args))");
+  s7_gc_protect(s7, apply_closure);
+  define_handle_type<Tween>(s7, "tween", tweens.map());
+  define_function<BIND(tween_vec2)>(s7, "tween-vec2!");
+  define_function<BIND(tween_float_vector)>(s7, "tween-float-vector!");
+  define_function<BIND(tween_call)>(s7, "tween-call!");
+  define_function<BIND(tween_delay)>(s7, "tween-delay!");
+  define_function<BIND(tween_on_done)>(s7, "tween-on-done!");
+  define_function<BIND(tween_kill)>(s7, "tween-kill!");
+  define_function<BIND(tween_count)>(s7, "tween-count");
+
+  curve_type_tag = s7_make_c_type(s7, "curve");
+  s7_c_type_set_free(s7, curve_type_tag, free_curve);
+  s7_c_type_set_to_string(s7, curve_type_tag, curve_to_string);
+  define_function<BIND(make_curve)>(s7, "make-curve");
+  define_function<BIND(make_ease_curve)>(s7, "make-ease-curve");
+  define_function<BIND(make_spline_curve)>(s7, "make-spline-curve");
+  define_function<BIND(curvep)>(s7, "curve?");
+  define_function<BIND(curve_value)>(s7, "curve-value");
+  define_function<BIND(curve_values)>(s7, "curve-values!");
+
+  spatial_hash_type_tag = s7_make_c_type(s7, "spatial-hash");
+  s7_c_type_set_free(s7, spatial_hash_type_tag, free_spatial_hash);
+  s7_c_type_set_to_string(s7, spatial_hash_type_tag, spatial_hash_to_string);
+  define_function<BIND(make_spatial_hash)>(s7, "make-spatial-hash");
+  define_function<BIND(spatial_hashp)>(s7, "spatial-hash?");
+  define_function<BIND(spatial_hash_insert)>(s7, "spatial-hash-insert!");
+  define_function<BIND(spatial_hash_move)>(s7, "spatial-hash-move!");
+  define_function<BIND(spatial_hash_update)>(s7, "spatial-hash-update!");
+  define_function<BIND(spatial_hash_remove)>(s7, "spatial-hash-remove!");
+  define_function<BIND(spatial_hash_clear)>(s7, "spatial-hash-clear!");
+  define_function<BIND(spatial_hash_count)>(s7, "spatial-hash-count");
+  define_function<BIND(spatial_hash_contains)>(s7, "spatial-hash-contains?");
+  define_function<BIND(spatial_hash_circle)>(s7, "spatial-hash-circle!");
+  define_function<BIND(spatial_hash_rect)>(s7, "spatial-hash-rect!");
+  define_function<BIND(spatial_hash_pairs)>(s7, "spatial-hash-pairs!");
+
+  define_function<BIND(collide_circles_overlapping_circle)>(s7, "circles-overlapping-circle!");
+  define_function<BIND(collide_circles_touching_segment)>(s7, "circles-touching-segment!");
+  define_function<BIND(collide_ray_circles)>(s7, "ray-circles!");
+  define_function<BIND(collide_ray_segments)>(s7, "ray-segments!");
+
+  define_function<BIND_AS(f32 (*)(f32, f32, f32), lerp)>(s7, "lerp");
+  define_function<BIND_AS(f32 (*)(f32, f32, f32), clamp)>(s7, "clamp");
+  define_function<BIND(clamp01)>(s7, "clamp01");
+  define_function<BIND(fuzzy_equal)>(s7, "fuzzy-equal?");
+  define_function<BIND(angles_diff)>(s7, "angles-diff");
+  define_function<BIND(angles_lerp)>(s7, "angles-lerp");
+  define_function<BIND(normalize_rad)>(s7, "normalize-rad");
+  define_function<BIND(normalize_deg)>(s7, "normalize-deg");
+  define_function<BIND(hermite_interp)>(s7, "hermite-interp");
+
+  define_function<BIND(ease_linear)>(s7, "ease-linear");
+  define_function<BIND(ease_cubic_in)>(s7, "ease-cubic-in");
+  define_function<BIND(ease_cubic_out)>(s7, "ease-cubic-out");
+  define_function<BIND(ease_cubic_in_out)>(s7, "ease-cubic-in-out");
+  define_function<BIND(ease_back_in)>(s7, "ease-back-in");
+  define_function<BIND(ease_back_out)>(s7, "ease-back-out");
+  define_function<BIND(ease_elastic_in)>(s7, "ease-elastic-in");
+  define_function<BIND(ease_elastic_out)>(s7, "ease-elastic-out");
+  define_function<BIND(ease_bounce_in)>(s7, "ease-bounce-in");
+  define_function<BIND(ease_bounce_out)>(s7, "ease-bounce-out");
+  define_function<BIND(rnd01)>(s7, "rnd01");
+  define_function<BIND(rnd_range)>(s7, "rnd");
+
+  rng_type_tag = s7_make_c_type(s7, "rng");
+  s7_c_type_set_free(s7, rng_type_tag, free_rng);
+  s7_c_type_set_to_string(s7, rng_type_tag, rng_to_string);
+  s7_c_type_set_is_equal(s7, rng_type_tag, rng_is_equal);
+
+  define_function<BIND(make_rng)>(s7, "make-rng");
+  define_function<BIND(rngp)>(s7, "rng?");
+  define_function<BIND(rng_next)>(s7, "rng-next");
+  define_function<BIND(rng_range)>(s7, "rng-range");
+  define_function<BIND(rng_integer)>(s7, "rng-integer");
+  define_function<BIND(rng_split)>(s7, "rng-split!");
+  define_function<BIND(rng_jump)>(s7, "rng-jump!");
+  define_function<BIND(rng_long_jump)>(s7, "rng-long-jump!");
+  define_function<BIND(rng_snapshot)>(s7, "rng-snapshot");
+  define_function<BIND(rng_restore)>(s7, "rng-restore!");
 
   load_script(s7, "main.scm");
 }
@@ -425,10 +1765,17 @@ int main()
   init_s7();
 
   int frame_counter = 0;
+  auto last_frame_start = std::chrono::steady_clock::now();
 
   while (1) {    // window_update()
 
     listen();
+    auto frame_start = std::chrono::steady_clock::now();
+
+    // at most 100ms, so a stall slows animations down instead of skipping them
+    const f32 dt = std::min(std::chrono::duration<f32>(frame_start - last_frame_start).count(), 0.1f);
+    last_frame_start = frame_start;
+    update_tweens(dt);
 
     // setup rendering...
 
@@ -440,13 +1787,19 @@ int main()
       s7_call(s7, frame_entry, s7_nil(s7));
       // TODO: error port?
     }
+    frame_temporaries().end_frame();
+
+    trim_pod_pools(pool_trim_policy);
 
     // flush rendering
 
+    frame_stats.end_frame(
+      std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
+
     //printf("%g fps\n", frame_counter / frame_time);
     frame_counter++;
   }
   sts_net_shutdown();
-  free(s7);
+  s7_free(s7);    // its memory came from s7_memory
   return 0;
 }
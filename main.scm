@@ -1,4 +1,4 @@
-(define-macro (dotimes spec . body)	;; spec = (var end . return)
+(define-expansion (dotimes spec . body)	;; spec = (var end . return), expanded at read time so the optimizer sees a plain do
   (let ((e (gensym))
 	    (n (car spec)))
 	`(do ((,e ,(cadr spec))
@@ -6,6 +6,12 @@
 	     ((>= ,n ,e) ,@(cddr spec))
 	   ,@body)))
 
+(set! *#readers*			;; #v(x y) => an immutable vec2, built once at read time
+      (cons (cons #\v (lambda (str)
+			(and (string=? str "v")
+			     (vec2-literal (read)))))
+	    *#readers*))
+
 
 (define (frame-entry)
   ;; (set-color 0 0 0 1)
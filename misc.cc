@@ -1,21 +1,88 @@
 // -*- c++ -*-
 #include "misc.h"
+#include "simd.h"
 #include <stdio.h>
+#include <string.h>
+#include <mutex>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 
-static u32 rnd_z = 12345;
-static u32 rnd_w = 65435;
+Rng Rng::seeded(u64 seed)
+{
+  // splitmix64, so that similar seeds give unrelated states
+  Rng r;
+  for (u32 i = 0; i < 4; i += 2) {
+    u64 z = (seed += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    r.s[i] = u32(z);
+    r.s[i + 1] = u32(z >> 32);
+  }
+  return r;
+}
+
+static void jump_by(u32 s[4], const u32 (&poly)[4])
+{
+  Rng r = {{s[0], s[1], s[2], s[3]}};
+  u32 t[4] = {0, 0, 0, 0};
+  for (u32 p : poly) {
+    for (int b = 0; b < 32; b++) {
+      if (p & (1u << b)) {
+        for (int i = 0; i < 4; i++) {
+          t[i] ^= r.s[i];
+        }
+      }
+      r.next();
+    }
+  }
+  for (int i = 0; i < 4; i++) {
+    s[i] = t[i];
+  }
+}
+
+void Rng::jump()
+{
+  static const u32 poly[4] = {0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b};
+  jump_by(s, poly);
+}
+
+void Rng::long_jump()
+{
+  static const u32 poly[4] = {0xb523952e, 0x0b6f099f, 0xccf5a0ef, 0x1c580662};
+  jump_by(s, poly);
+}
+
+static Rng split_thread_stream()
+{
+  static std::mutex mutex;
+  static Rng streams = Rng::seeded(12345);
+  std::lock_guard<std::mutex> lock(mutex);
+  return streams.split();
+}
+
+// trivially constructible, so the fast path is a plain TLS access
+static thread_local Rng thread_stream;
+static thread_local bool thread_stream_split;
+
+Rng& thread_rng()
+{
+  if (!thread_stream_split) {
+    thread_stream = split_thread_stream();
+    thread_stream_split = true;
+  }
+  return thread_stream;
+}
 
 unsigned rnd()
 {
-  rnd_z = 36969 * (rnd_z & 65535) + (rnd_z >> 16);
-  rnd_w = 18000 * (rnd_w & 65535) + (rnd_w >> 16);
-  return (rnd_z << 16) + rnd_w;
+  return thread_rng().next();
 }
 
 f32 rnd01()
 {
-  unsigned val = rnd() & UINT16_MAX;
-  return f32(val) * (1.0 / f32(UINT16_MAX));
+  return thread_rng().next01();
 }
 
 bool fuzzy_equal(f32 a, f32 b)
@@ -34,17 +101,7 @@ bool fuzzy_equal(f32 a, f32 b)
 
 f32 angles_lerp(f32 a, f32 b, f32 t)
 {
-  a = normalize_rad(a);
-  b = normalize_rad(b);
-  f32 delta = b - a;
-  if (fabsf(delta) > PI) {
-    if (delta > 0) {
-      a += TWO_PI;
-    } else {
-      b += TWO_PI;
-    }
-  }
-  return normalize_rad(lerp(a, b, t));
+  return normalize_rad(a + angles_diff(a, b) * t);
 }
 
 Vec2 bezier4(const Vec2& p0, const Vec2& p1, const Vec2& p2, const Vec2& p3, f32 t)
@@ -70,21 +127,64 @@ Vec2 bezier4_tangent(const Vec2& p0, const Vec2& p1, const Vec2& p2, const Vec2&
   return normalized(p0 * t0 + p1 * t1 + p2 * t2 + p3 * t3);
 }
 
+// the polynomials of the lane-wise fast_sincos in simd.h, with the
+// quadrant taken as an integer: one table load and two sign flips
+void fast_sincos(f32 a, f32* s, f32* c)
+{
+  if (fabsf(a) > FAST_TRIG_RANGE) {
+    *s = sinf(a);
+    *c = cosf(a);
+    return;
+  }
+  const f32 qf = round_nearest(a * 0.63661977236758134f);    // 2 / PI
+  const i32 q = i32(qf);
+  const f32 r = ((a - qf * PIO2_A) - qf * PIO2_B) - qf * PIO2_C;
+  const f32 r2 = r * r;
+  const f32 sc[2] = {
+    r + r * r2 * (SIN_P0 + r2 * (SIN_P1 + r2 * SIN_P2)),
+    1.0f - 0.5f * r2 + r2 * r2 * (COS_P0 + r2 * (COS_P1 + r2 * COS_P2)),
+  };
+  u32 us, uc;
+  memcpy(&us, &sc[q & 1], 4);
+  memcpy(&uc, &sc[(q & 1) ^ 1], 4);
+  us ^= u32(q & 2) << 30;
+  uc ^= u32((q + 1) & 2) << 30;
+  memcpy(s, &us, 4);
+  memcpy(c, &uc, 4);
+}
+
+// one SSE lane where there is SSE: its selects are plain bit masks
+f32 fast_atan2(f32 y, f32 x)
+{
+#if defined(__SSE2__)
+  typedef Sse L;
+#else
+  typedef Scalar L;
+#endif
+  f32 tmp[L::width];
+  fast_atan2(F32x<L>::splat(y), F32x<L>::splat(x)).store(tmp);
+  return tmp[0];
+}
+
 Vec2 rotate(const Vec2& v, f32 a)
 {
-  const f32 s = sinf(a);
-  const f32 c = cosf(a);
+  f32 s, c;
+  sin_cos(a, &s, &c);
   return vec2(v.x * c - v.y * s, v.y * c + v.x * s);
 }
 
 Vec2 xunit_rotated(f32 a)
 {
-  return vec2(cosf(a), sinf(a));
+  f32 s, c;
+  sin_cos(a, &s, &c);
+  return vec2(c, s);
 }
 
 Vec2 yunit_rotated(f32 a)
 {
-  return vec2(-sinf(a), cosf(a));
+  f32 s, c;
+  sin_cos(a, &s, &c);
+  return vec2(-s, c);
 }
 
 f32 hermite_interp(f32 y0, f32 y1, f32 y2, f32 y3, f32 mu)
@@ -102,3 +202,10 @@ f32 hermite_interp(f32 y0, f32 y1, f32 y2, f32 y3, f32 mu)
   f32 a3 = -2 * mu3 + 3 *mu2;
   return a0 * y1 + a1 * m0 + a2 * m1 + a3 * y2;
 }
+
+void release_free_memory()
+{
+#if defined(__GLIBC__)
+  malloc_trim(0);
+#endif
+}
@@ -0,0 +1,469 @@
+// -*- c++ -*-
+#pragma once
+
+// s7 c-types for plain structs of f32 fields, declared from a field list:
+//
+//   template <> struct Arg<Vec3*> : PodArg<Vec3> {};
+//   template <> struct Ret<Vec3> : PodRet<Vec3> {};
+//
+//   define_pod_type<Vec3, &Vec3::x, &Vec3::y, &Vec3::z>(sc, "vec3", {"x", "y", "z"});
+//
+// defines (vec3 x y z), vec3?, the vec3-x .. vec3-z accessors (settable,
+// with d_p getters for the optimizer), printing as <vec3 1.0000 ...>,
+// equal?/equivalent? and hashing. Values live in a ConcurrentPool<T>, one
+// per type, and go back to it from the free hook. Worker threads may
+// allocate from PodType<T>::pool too and hand the object to the
+// interpreter thread, which wraps it with PodType<T>::adopt.
+//
+// Inside (with-frame-temporaries ...) values come from a bump arena
+// instead, see FrameTemporaries.
+
+#include "misc.h"
+#include "bind.h"
+#include "concurrent_pool.h"
+#include <string>
+#include <stdio.h>
+#include <string.h>
+
+// Pod values made while depth > 0, i.e. inside (with-frame-temporaries
+// ...), are bump-allocated from a ring of chunks instead of the pools.
+// The free hook counts a chunk's objects down; end_frame() moves on to a
+// fresh chunk, and a chunk is reused once everything in it was collected.
+// Escaping values are therefore safe, they only pin their chunk: after a
+// GC has run since the chunk was retired, whatever is still in it is live
+// and gets promoted (copied into its pool), which frees the chunk. A GC
+// epoch comes from the mark hook of one protected sentinel object.
+struct FrameTemporaries;
+inline FrameTemporaries& frame_temporaries();
+
+struct FrameTemporaries
+{
+  struct Header
+  {
+    s7_pointer obj;    // 0 once collected or promoted
+    void (*promote)(s7_pointer);
+    u32 size;
+  };
+
+  enum ChunkState
+  {
+    CHUNK_FREE,
+    CHUNK_CURRENT,
+    CHUNK_RETIRED
+  };
+
+  struct Chunk
+  {
+    ChunkState state;
+    u32 top;
+    u32 live;
+    u64 retired_at;    // epoch
+  };
+
+  static const u32 CHUNK_SIZE = 64 * 1024;
+  static const u32 CHUNKS = 16;
+
+  u8* mem = new u8[CHUNK_SIZE * CHUNKS];
+  Chunk chunks[CHUNKS] = {};
+  u32 current = 0;
+  u32 depth = 0;
+  u64 epoch = 0;    // GCs so far
+  bool exhausted = false;    // no chunk to move to until one empties or a GC runs
+
+  FrameTemporaries()
+  {
+    chunks[0].state = CHUNK_CURRENT;
+  }
+
+  static s7_pointer count_gc(s7_scheme*, s7_pointer)
+  {
+    FrameTemporaries& ft = frame_temporaries();
+    ft.epoch++;
+    ft.exhausted = false;
+    return 0;
+  }
+
+  void init(s7_scheme* sc)
+  {
+    s7_int tag = s7_make_c_type(sc, "gc-epoch");
+    s7_c_type_set_gc_mark(sc, tag, count_gc);
+    s7_gc_protect(sc, s7_make_c_object(sc, tag, 0));
+  }
+
+  inline bool owns(const void* p) const
+  {
+    return p >= mem && p < mem + CHUNK_SIZE * CHUNKS;
+  }
+
+  template <typename T>
+  inline T* allocate(void (*promote)(s7_pointer))
+  {
+    const u32 size = (sizeof(Header) + sizeof(T) + 7) & ~7u;
+    if (chunks[current].top + size > CHUNK_SIZE && !next_chunk()) {
+      return 0;
+    }
+    Chunk& c = chunks[current];
+    Header* h = (Header*)(mem + current * CHUNK_SIZE + c.top);
+    c.top += size;
+    c.live++;
+    h->obj = 0;
+    h->promote = promote;
+    h->size = size;
+    return (T*)(h + 1);
+  }
+
+  // value was allocated by allocate() and is now owned by obj
+  static inline void adopted(void* value, s7_pointer obj)
+  {
+    ((Header*)value - 1)->obj = obj;
+  }
+
+  inline void free(void* value)
+  {
+    ((Header*)value - 1)->obj = 0;
+    Chunk& c = chunks[((u8*)value - mem) / CHUNK_SIZE];
+    if (--c.live == 0) {
+      if (c.state == CHUNK_CURRENT) {
+        c.top = 0;
+      }
+      exhausted = false;
+    }
+  }
+
+  void promote_survivors(Chunk& c, u8* base)
+  {
+    for (u32 at = 0; at < c.top;) {
+      Header* h = (Header*)(base + at);
+      if (h->obj) {
+        h->promote(h->obj);
+        h->obj = 0;
+        c.live--;
+      }
+      at += h->size;
+    }
+    assert(c.live == 0);
+  }
+
+  // a chunk that is empty, or can be emptied by promoting its survivors
+  bool next_chunk()
+  {
+    if (exhausted) {
+      return false;
+    }
+    u32 next = CHUNKS;
+    for (u32 i = 1; i < CHUNKS && next == CHUNKS; i++) {
+      u32 j = (current + i) % CHUNKS;
+      if (chunks[j].state == CHUNK_FREE || chunks[j].live == 0) {
+        next = j;
+      }
+    }
+    for (u32 i = 1; i < CHUNKS && next == CHUNKS; i++) {
+      u32 j = (current + i) % CHUNKS;
+      if (chunks[j].retired_at < epoch) {
+        promote_survivors(chunks[j], mem + j * CHUNK_SIZE);
+        next = j;
+      }
+    }
+    if (next == CHUNKS) {
+      exhausted = true;
+      return false;
+    }
+    chunks[current].state = CHUNK_RETIRED;
+    chunks[current].retired_at = epoch;
+    current = next;
+    chunks[current] = Chunk{CHUNK_CURRENT, 0, 0, 0};
+    return true;
+  }
+
+  void end_frame()
+  {
+    if (chunks[current].top > 0) {
+      next_chunk();
+    }
+  }
+
+  // chunks still holding objects, for the stats report
+  u32 chunks_in_use() const
+  {
+    u32 n = 0;
+    for (const Chunk& c : chunks) {
+      n += c.live > 0;
+    }
+    return n;
+  }
+};
+
+inline FrameTemporaries& frame_temporaries()
+{
+  static FrameTemporaries temporaries;
+  return temporaries;
+}
+
+template <typename T>
+struct PodType
+{
+  static int tag;
+  static const char* name;
+  static std::string predicate;
+  static ConcurrentPool<T>* pool;
+  static PoolStats counts;    // objects s7 owns; blocks come from pool
+
+  static bool is(s7_pointer p)
+  {
+    return s7_is_c_object(p) && s7_c_object_type(p) == tag;
+  }
+
+  static T* value(s7_pointer p)
+  {
+    return (T*)s7_c_object_value(p);
+  }
+
+  static s7_pointer make(s7_scheme* sc, const T& v)
+  {
+    FrameTemporaries& ft = frame_temporaries();
+    if (ft.depth) {
+      if (T* p = ft.allocate<T>(promote)) {
+        *p = v;
+        s7_pointer o = adopt(sc, p);
+        FrameTemporaries::adopted(p, o);
+        return o;
+      }
+    }
+    T* p = pool->allocate();
+    *p = v;
+    return adopt(sc, p);
+  }
+
+  // p must come from pool; s7 owns it from now on
+  static s7_pointer adopt(s7_scheme* sc, T* p)
+  {
+    counts.allocations++;
+    if (++counts.live > counts.high_water) {
+      counts.high_water = counts.live;
+    }
+    return s7_make_c_object(sc, tag, p);
+  }
+
+  static void free(void* val)
+  {
+    counts.frees++;
+    counts.live--;
+    FrameTemporaries& ft = frame_temporaries();
+    if (ft.owns(val)) {
+      ft.free(val);
+    } else {
+      pool->free((T*)val);
+    }
+  }
+
+  // moves a frame temporary that outlived its chunk into the pool
+  static void promote(s7_pointer o)
+  {
+    T* p = pool->allocate();
+    *p = *value(o);
+    *(void**)s7_c_object_inline_value(o) = p;
+  }
+
+  static u32 maybe_trim(const TrimPolicy& policy)
+  {
+    return pool->maybe_trim(policy);
+  }
+
+  static PoolStats stats()
+  {
+    PoolStats s = counts;
+    s.blocks = pool->blocks();
+    return s;
+  }
+};
+
+// every pod type, for trim_pod_pools and the stats report
+struct PodPool
+{
+  const char* name;
+  u32 (*maybe_trim)(const TrimPolicy&);
+  PoolStats (*stats)();
+};
+
+inline std::vector<PodPool>& pod_pools()
+{
+  static std::vector<PodPool> pools;
+  return pools;
+}
+
+// from the interpreter thread, once per frame; returns blocks released
+inline u32 trim_pod_pools(const TrimPolicy& policy)
+{
+  u32 released = 0;
+  for (const PodPool& p : pod_pools()) {
+    released += p.maybe_trim(policy);
+  }
+  return released;
+}
+
+template <typename T>
+int PodType<T>::tag = 0;
+
+template <typename T>
+const char* PodType<T>::name = 0;
+
+template <typename T>
+std::string PodType<T>::predicate;
+
+template <typename T>
+ConcurrentPool<T>* PodType<T>::pool = 0;
+
+template <typename T>
+PoolStats PodType<T>::counts;
+
+template <typename T>
+struct PodArg
+{
+  static bool is(s7_pointer p) { return PodType<T>::is(p); }
+  static T* get(s7_scheme*, s7_pointer p) { return PodType<T>::value(p); }
+  static const char* type_name() { return PodType<T>::name; }
+  static const char* predicate() { return PodType<T>::predicate.c_str(); }
+};
+
+template <typename T>
+struct PodRet
+{
+  static s7_pointer make(s7_scheme* sc, const T& v) { return PodType<T>::make(sc, v); }
+  static const char* predicate() { return PodType<T>::predicate.c_str(); }
+};
+
+template <typename T, f32 T::*>
+struct FieldValue
+{
+  typedef f32 type;
+};
+
+template <typename T, f32 T::*M>
+static f32 pod_field(T* o)
+{
+  return o->*M;
+}
+
+template <typename T, f32 T::*M>
+static void set_pod_field(Ref<T> o, f32 v)
+{
+  (*o).*M = v;
+}
+
+template <typename T, f32 T::*M>
+static void define_pod_field(s7_scheme* sc, const char* type_name, const char* field)
+{
+  static const std::string name = std::string(type_name) + "-" + field;
+  define_accessor<f32 (*)(T*), &pod_field<T, M>, void (*)(Ref<T>, f32), &set_pod_field<T, M>>(
+    sc, name.c_str());
+}
+
+template <typename T>
+static bool is_pod(s7_pointer o)
+{
+  return PodType<T>::is(o);
+}
+
+template <typename T, f32 T::*... M>
+struct PodFields
+{
+  static_assert(std::is_pod<T>::value, "PodFields type must be POD");
+  static_assert(sizeof(T) == sizeof...(M) * sizeof(f32), "every field of T must be listed");
+
+  static T make(typename FieldValue<T, M>::type... v)
+  {
+    T o;
+    const int unused[] = {0, (o.*M = v, 0)...};
+    (void)unused;
+    return o;
+  }
+
+  static s7_pointer to_string(s7_scheme* sc, s7_pointer args)
+  {
+    s7_pointer o = s7_car(args);
+    if (!PodType<T>::is(o)) {
+      return s7_wrong_type_arg_error(sc, "pod to string", 1, o, PodType<T>::name);
+    }
+    const T* v = PodType<T>::value(o);
+    char buf[256];
+    int n = snprintf(buf, sizeof(buf), "<%s", PodType<T>::name);
+    const f32 fields[] = {(v->*M)...};
+    for (f32 f : fields) {
+      n += snprintf(buf + n, sizeof(buf) - n, " %.4f", f);
+    }
+    snprintf(buf + n, sizeof(buf) - n, ">");
+    return s7_make_string(sc, buf);
+  }
+
+  // equal? is exact, equivalent? fuzzy, as for vec2
+  static s7_pointer is_equal(s7_scheme* sc, s7_pointer args)
+  {
+    s7_pointer a = s7_car(args), b = s7_cadr(args);
+    if (!PodType<T>::is(a) || !PodType<T>::is(b)) {
+      return s7_f(sc);
+    }
+    const T* va = PodType<T>::value(a);
+    const T* vb = PodType<T>::value(b);
+    const bool same[] = {true, (va->*M == vb->*M)...};
+    for (bool s : same) {
+      if (!s) {
+        return s7_f(sc);
+      }
+    }
+    return s7_t(sc);
+  }
+
+  static s7_pointer is_equivalent(s7_scheme* sc, s7_pointer args)
+  {
+    s7_pointer a = s7_car(args), b = s7_cadr(args);
+    if (!PodType<T>::is(a) || !PodType<T>::is(b)) {
+      return s7_f(sc);
+    }
+    const T* va = PodType<T>::value(a);
+    const T* vb = PodType<T>::value(b);
+    const bool same[] = {true, fuzzy_equal(va->*M, vb->*M)...};
+    for (bool s : same) {
+      if (!s) {
+        return s7_f(sc);
+      }
+    }
+    return s7_t(sc);
+  }
+
+  static s7_int hash(s7_scheme*, s7_pointer o)
+  {
+    const T* v = PodType<T>::value(o);
+    const f32 fields[] = {(v->*M + 0.0f)...};    // -0 -> 0
+    u64 h = 0;
+    for (f32 f : fields) {
+      u32 bits;
+      memcpy(&bits, &f, sizeof(bits));
+      h = (h ^ bits) * 0x9e3779b97f4a7c15ull;
+      h ^= h >> 31;
+    }
+    return (s7_int)(h >> 1);
+  }
+};
+
+template <typename T, f32 T::*... M>
+void define_pod_type(s7_scheme* sc, const char* name, const char* const (&fields)[sizeof...(M)],
+                     u32 pool_grow = 1024)
+{
+  typedef PodFields<T, M...> F;
+  PodType<T>::name = name;
+  PodType<T>::predicate = std::string(name) + "?";
+  PodType<T>::pool = new ConcurrentPool<T>(pool_grow);
+  pod_pools().push_back(PodPool{name, PodType<T>::maybe_trim, PodType<T>::stats});
+  PodType<T>::tag = s7_make_c_type(sc, name);
+  s7_c_type_set_free(sc, PodType<T>::tag, PodType<T>::free);
+  s7_c_type_set_to_string(sc, PodType<T>::tag, F::to_string);
+  s7_c_type_set_is_equal(sc, PodType<T>::tag, F::is_equal);
+  s7_c_type_set_is_equivalent(sc, PodType<T>::tag, F::is_equivalent);
+  s7_c_type_set_hash(sc, PodType<T>::tag, F::hash);
+
+  define_function<BIND(F::make)>(sc, name);
+  define_function<BIND(is_pod<T>)>(sc, PodType<T>::predicate.c_str());
+  int i = 0;
+  const int unused[] = {0, (define_pod_field<T, M>(sc, name, fields[i++]), 0)...};
+  (void)unused;
+}
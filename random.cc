@@ -0,0 +1,196 @@
+// -*- c++ -*-
+#include "random.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Four xoshiro128** streams side by side, state word k of lane j in
+// s[k][j]. The multiplications by 5 and 9 are shifts and adds, so plain
+// SSE2 runs all four lanes at once.
+struct LaneRng
+{
+  static const u32 LANES = 4;
+  alignas(16) u32 s[4][LANES];
+
+  LaneRng(Rng& rng)
+  {
+    for (u32 j = 0; j < LANES; j++) {
+      u64 seed = u64(rng.next()) << 32;
+      Rng lane = Rng::seeded(seed | rng.next());
+      for (u32 k = 0; k < 4; k++) {
+        s[k][j] = lane.s[k];
+      }
+    }
+  }
+
+  // n uniforms in [0, 1), n a multiple of LANES
+  void next01(f32* out, u32 n)
+  {
+#if defined(__SSE2__)
+    __m128i s0 = _mm_load_si128((const __m128i*)s[0]);
+    __m128i s1 = _mm_load_si128((const __m128i*)s[1]);
+    __m128i s2 = _mm_load_si128((const __m128i*)s[2]);
+    __m128i s3 = _mm_load_si128((const __m128i*)s[3]);
+    const __m128 scale = _mm_set1_ps(1.0f / 16777216.0f);
+    for (u32 i = 0; i < n; i += LANES) {
+      __m128i x = _mm_add_epi32(_mm_slli_epi32(s1, 2), s1);            // s1 * 5
+      x = _mm_or_si128(_mm_slli_epi32(x, 7), _mm_srli_epi32(x, 25));    // rotl 7
+      x = _mm_add_epi32(_mm_slli_epi32(x, 3), x);                       // * 9
+      const __m128i t = _mm_slli_epi32(s1, 9);
+      s2 = _mm_xor_si128(s2, s0);
+      s3 = _mm_xor_si128(s3, s1);
+      s1 = _mm_xor_si128(s1, s2);
+      s0 = _mm_xor_si128(s0, s3);
+      s2 = _mm_xor_si128(s2, t);
+      s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+      _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(x, 8)), scale));
+    }
+    _mm_store_si128((__m128i*)s[0], s0);
+    _mm_store_si128((__m128i*)s[1], s1);
+    _mm_store_si128((__m128i*)s[2], s2);
+    _mm_store_si128((__m128i*)s[3], s3);
+#else
+    for (u32 i = 0; i < n; i += LANES) {
+      for (u32 j = 0; j < LANES; j++) {
+        Rng lane = {{s[0][j], s[1][j], s[2][j], s[3][j]}};
+        out[i + j] = lane.next01();
+        for (u32 k = 0; k < 4; k++) {
+          s[k][j] = lane.s[k];
+        }
+      }
+    }
+#endif
+  }
+};
+
+// uniforms one at a time, generated a block ahead
+class UniformStream
+{
+  static const u32 BLOCK = 256;
+  LaneRng lanes;
+  f32 block[BLOCK];
+  u32 at = BLOCK;
+
+public:
+  UniformStream(Rng& rng) : lanes(rng) {}
+
+  inline f32 next()
+  {
+    if (at == BLOCK) {
+      lanes.next01(block, BLOCK);
+      at = 0;
+    }
+    return block[at++];
+  }
+
+  // a point uniform in the unit disc, by rejection (79% accepted)
+  inline f32 in_disc(f32& x, f32& y)
+  {
+    f32 s;
+    do {
+      x = next() * 2 - 1;
+      y = next() * 2 - 1;
+      s = x * x + y * y;
+    } while (s >= 1 || s < 1e-12f);
+    return s;
+  }
+};
+
+template <typename F>
+static void uniform_k(Rng& rng, F* out, u32 n, F lo, F hi)
+{
+  const u32 BLOCK = 256;
+  LaneRng lanes(rng);
+  f32 block[BLOCK];
+  const F range = hi - lo;
+  for (u32 i = 0; i < n; i += BLOCK) {
+    const u32 m = std::min(BLOCK, n - i);
+    lanes.next01(block, (m + LaneRng::LANES - 1) & ~(LaneRng::LANES - 1));
+    for (u32 j = 0; j < m; j++) {
+      out[i + j] = lo + F(block[j]) * range;
+    }
+  }
+}
+
+void random_uniform(Rng& rng, f32* out, u32 n, f32 lo, f32 hi)
+{
+  uniform_k(rng, out, n, lo, hi);
+}
+
+void random_uniform(Rng& rng, f64* out, u32 n, f64 lo, f64 hi)
+{
+  uniform_k(rng, out, n, lo, hi);
+}
+
+// Marsaglia's polar method: two normals per accepted point
+template <typename F>
+static void normal_k(Rng& rng, F* out, u32 n, F mean, F sd)
+{
+  UniformStream u(rng);
+  for (u32 i = 0; i < n; i += 2) {
+    f32 x, y;
+    const f32 s = u.in_disc(x, y);
+    const f32 m = sqrtf(-2 * logf(s) / s);
+    out[i] = mean + F(x * m) * sd;
+    if (i + 1 < n) {
+      out[i + 1] = mean + F(y * m) * sd;
+    }
+  }
+}
+
+void random_normal(Rng& rng, f32* out, u32 n, f32 mean, f32 sd)
+{
+  normal_k(rng, out, n, mean, sd);
+}
+
+void random_normal(Rng& rng, f64* out, u32 n, f64 mean, f64 sd)
+{
+  normal_k(rng, out, n, mean, sd);
+}
+
+template <typename F>
+static void disc_k(Rng& rng, F* xs, F* ys, u32 stride, u32 n, F cx, F cy, F r)
+{
+  UniformStream u(rng);
+  for (u32 i = 0; i < n; i++) {
+    f32 x, y;
+    u.in_disc(x, y);
+    xs[i * stride] = cx + F(x) * r;
+    ys[i * stride] = cy + F(y) * r;
+  }
+}
+
+void random_disc(Rng& rng, f32* xs, f32* ys, u32 stride, u32 n, f32 cx, f32 cy, f32 r)
+{
+  disc_k(rng, xs, ys, stride, n, cx, cy, r);
+}
+
+void random_disc(Rng& rng, f64* xs, f64* ys, u32 stride, u32 n, f64 cx, f64 cy, f64 r)
+{
+  disc_k(rng, xs, ys, stride, n, cx, cy, r);
+}
+
+// a point in the disc, pushed out to the circle: no trig, and uniform in
+// angle because the disc sample is
+template <typename F>
+static void circle_k(Rng& rng, F* xs, F* ys, u32 stride, u32 n, F cx, F cy, F r)
+{
+  UniformStream u(rng);
+  for (u32 i = 0; i < n; i++) {
+    f32 x, y;
+    const f32 inv = 1 / sqrtf(u.in_disc(x, y));
+    xs[i * stride] = cx + F(x * inv) * r;
+    ys[i * stride] = cy + F(y * inv) * r;
+  }
+}
+
+void random_circle(Rng& rng, f32* xs, f32* ys, u32 stride, u32 n, f32 cx, f32 cy, f32 r)
+{
+  circle_k(rng, xs, ys, stride, n, cx, cy, r);
+}
+
+void random_circle(Rng& rng, f64* xs, f64* ys, u32 stride, u32 n, f64 cx, f64 cy, f64 r)
+{
+  circle_k(rng, xs, ys, stride, n, cx, cy, r);
+}
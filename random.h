@@ -0,0 +1,22 @@
+// -*- c++ -*-
+#pragma once
+
+#include "misc.h"
+
+// Bulk random numbers drawn from an Rng. Each call seeds four lane
+// streams from rng (advancing it by eight numbers) and generates four
+// uniforms at a time, SSE2 on x86-64, so the output depends only on rng's
+// state. Pairs go to xs[i * stride], ys[i * stride]: stride 1 for a
+// Vec2Buffer, 2 (ys = xs + 1) for an interleaved float-vector.
+
+void random_uniform(Rng& rng, f32* out, u32 n, f32 lo, f32 hi);    // [lo, hi)
+void random_uniform(Rng& rng, f64* out, u32 n, f64 lo, f64 hi);
+
+void random_normal(Rng& rng, f32* out, u32 n, f32 mean, f32 sd);
+void random_normal(Rng& rng, f64* out, u32 n, f64 mean, f64 sd);
+
+// uniform inside the disc, or on the circle, of radius r around (cx, cy)
+void random_disc(Rng& rng, f32* xs, f32* ys, u32 stride, u32 n, f32 cx, f32 cy, f32 r);
+void random_disc(Rng& rng, f64* xs, f64* ys, u32 stride, u32 n, f64 cx, f64 cy, f64 r);
+void random_circle(Rng& rng, f32* xs, f32* ys, u32 stride, u32 n, f32 cx, f32 cy, f32 r);
+void random_circle(Rng& rng, f64* xs, f64* ys, u32 stride, u32 n, f64 cx, f64 cy, f64 r);
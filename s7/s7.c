@@ -624,6 +624,7 @@ typedef struct {
   s7_pointer (*to_string)  (s7_scheme *sc, s7_pointer args);
   s7_pointer (*gc_mark)    (s7_scheme *sc, s7_pointer args);
   s7_pointer (*gc_free)    (s7_scheme *sc, s7_pointer args);
+  s7_int     (*hash)       (s7_scheme *sc, s7_pointer obj);
 } c_object_t;
 
 
@@ -1410,31 +1411,45 @@ static s7_scheme *cur_sc = NULL; /* intended for gdb (see gdbinit), but also use
 
 static noreturn void s7_error_nr(s7_scheme *sc, s7_pointer type, s7_pointer info);
 
+/* all of s7's own memory goes through allocator (see s7_init_with_allocator); it is process-wide
+ *   because many of the callers below have no s7_scheme at hand
+ */
+static void *libc_malloc(void *data, size_t bytes) {return(malloc(bytes));}
+static void *libc_calloc(void *data, size_t count, size_t size) {return(calloc(count, size));}
+static void *libc_realloc(void *data, void *ptr, size_t bytes) {return(realloc(ptr, bytes));}
+static void libc_free(void *data, void *ptr) {free(ptr);}
+
+static const s7_allocator libc_allocator = {libc_malloc, libc_calloc, libc_realloc, libc_free, NULL};
+static s7_allocator allocator = {libc_malloc, libc_calloc, libc_realloc, libc_free, NULL};
+static int32_t live_interpreters = 0; /* s7_init'd and not yet s7_free'd, all sharing allocator */
+
+#define Free(Ptr) allocator.free(allocator.data, Ptr)
+
 #if POINTER_32
 static void *Malloc(size_t bytes)
 {
-  void *p = malloc(bytes);
+  void *p = allocator.malloc(allocator.data, bytes);
   if (!p) s7_error_nr(cur_sc, cur_sc->out_of_memory_symbol, cur_sc->nil);
   return(p);
 }
 
 static void *Calloc(size_t nmemb, size_t size)
 {
-  void *p = calloc(nmemb, size);
+  void *p = allocator.calloc(allocator.data, nmemb, size);
   if (!p) s7_error_nr(cur_sc, cur_sc->out_of_memory_symbol, cur_sc->nil);
   return(p);
 }
 
 static void *Realloc(void *ptr, size_t size)
 {
-  void *p = realloc(ptr, size);
+  void *p = allocator.realloc(allocator.data, ptr, size);
   if (!p) s7_error_nr(cur_sc, cur_sc->out_of_memory_symbol, cur_sc->nil);
   return(p);
 }
 #else
-#define Malloc malloc
-#define Calloc calloc
-#define Realloc realloc
+#define Malloc(Bytes) allocator.malloc(allocator.data, Bytes)
+#define Calloc(Count, Size) allocator.calloc(allocator.data, Count, Size)
+#define Realloc(Ptr, Bytes) allocator.realloc(allocator.data, Ptr, Bytes)
 #endif
 
 
@@ -1520,7 +1535,7 @@ static inline void liberate(s7_scheme *sc, block_t *p)
     {
       if (block_data(p))
 	{
-	  free(block_data(p));
+	  Free(block_data(p));
 	  block_data(p) = NULL;
 	}
       block_next(p) = (struct block_t *)sc->block_lists[BLOCK_LIST];
@@ -3460,6 +3475,7 @@ static s7_pointer slot_expression(s7_pointer p)    \
 #define c_object_reverse(Sc, p)        c_object_info(Sc, p)->reverse
 #define c_object_to_list(Sc, p)        c_object_info(Sc, p)->to_list
 #define c_object_to_string(Sc, p)      c_object_info(Sc, p)->to_string
+#define c_object_hash(Sc, p)           c_object_info(Sc, p)->hash
 #define c_object_scheme_name(Sc, p)    T_Str(c_object_info(Sc, p)->scheme_name)
 
 #define c_pointer(p)                   (T_Ptr(p))->object.cptr.c_pointer
@@ -5072,7 +5088,7 @@ static s7_pointer check_ref15(s7_pointer p, const char *func, int32_t line) /* c
       (!safe_strcmp(func, "mark_slot"))) /* match == multiple-values which causes false error messages */
     complain("%s%s[%d]: slot value is a multiple-value, %s (%s)%s?\n", p, func, line, typ);
   if (has_odd_bits(p))
-    {char *s; fprintf(stderr, "odd bits: %s\n", s = describe_type_bits(cur_sc, p)); free(s);}
+    {char *s; fprintf(stderr, "odd bits: %s\n", s = describe_type_bits(cur_sc, p)); Free(s);}
   return(p);
 }
 
@@ -5133,7 +5149,7 @@ static void print_gc_info(s7_scheme *sc, s7_pointer obj, int32_t line)
 		(obj->explicit_free_line > 0) ? fline : "", obj->gc_func, obj->gc_line,	UNBOLD_TEXT);
 	if (S7_DEBUGGING) fprintf(stderr, ", last gc line: %d", sc->last_gc_line);
 	fprintf(stderr, "\n");
-	free(bits);
+	Free(bits);
       }
   if (sc->stop_at_error) abort();
 }
@@ -5200,7 +5216,7 @@ static void show_opt1_bits(s7_pointer p, const char *func, int32_t line, uint64_
 	  p, p->object.cons.opt1,
 	  opt1_role_name(role),
 	  p->debugger_bits, bits, (s7_int)role);
-  free(bits);
+  Free(bits);
 }
 
 static s7_pointer opt1_1(s7_scheme *sc, s7_pointer p, uint64_t role, const char *func, int32_t line)
@@ -5262,7 +5278,7 @@ static void show_opt2_bits(s7_pointer p, const char *func, int32_t line, uint64_
 	  opt2_role_name(role),
 	  p->debugger_bits, bits, (s7_int)role,
 	  opt2_role_name(role));
-  free(bits);
+  Free(bits);
 }
 
 static bool f_call_func_mismatch(const char *func)
@@ -5359,7 +5375,7 @@ static void show_opt3_bits(s7_pointer p, const char *func, int32_t line, uint64_
 {
   char *bits = show_debugger_bits(p);
   fprintf(stderr, "%s%s[%d]%s: opt3: %s %" PRIx64 "%s", BOLD_TEXT, func, line, UNBOLD_TEXT, opt3_role_name(role), p->debugger_bits, bits);
-  free(bits);
+  Free(bits);
 }
 
 static void check_opt3_bits(s7_scheme *sc, s7_pointer p, uint64_t role, const char *func, int32_t line)
@@ -5489,9 +5505,9 @@ static void print_debugging_state(s7_scheme *sc, s7_pointer obj, s7_pointer port
 		  obj->current_alloc_func, obj->current_alloc_line, allocated_bits,
 		  obj->previous_alloc_func, obj->previous_alloc_line, previous_bits,
 		  obj->uses);
-  free(current_bits);
-  free(allocated_bits);
-  free(previous_bits);
+  Free(current_bits);
+  Free(allocated_bits);
+  Free(previous_bits);
   if (is_null(port))
     fprintf(stderr, "%p: %s\n", obj, str);
   else port_write_string(port)(sc, str, clamp_length(nlen, len), port);
@@ -5507,7 +5523,7 @@ static s7_pointer check_null_sym(s7_scheme *sc, s7_pointer p, s7_pointer sym, in
       char *s = describe_type_bits(sc, sym);
       fprintf(stderr, "%s%s[%d]: %s unbound%s\n", BOLD_TEXT, func, line, symbol_name(sym), UNBOLD_TEXT);
       fprintf(stderr, "  symbol_id: %" ld64 ", let_id: %" ld64 ", bits: %s", symbol_id(sym), let_id(sc->curlet), s);
-      free(s);
+      Free(s);
       if (is_slot(slot)) fprintf(stderr, ", slot: %s", display(slot));
       fprintf(stderr, "\n");
       if (sc->stop_at_error) abort();
@@ -5662,7 +5678,7 @@ static const char *make_type_name(s7_scheme *sc, const char *name, article_t art
   s7_int len = slen + 8;
   if (len > sc->typnam_len)
     {
-      if (sc->typnam) free(sc->typnam);
+      if (sc->typnam) Free(sc->typnam);
       sc->typnam = (char *)Malloc(len);
       sc->typnam_len = len;
     }
@@ -6545,7 +6561,7 @@ static void sweep(s7_scheme *sc)
   if (gp->loc == 0) mark_function[T_SYMBOL] = mark_noop;
 
   gp = sc->undefineds;
-  process_gc_list(free(undefined_name(s1)))
+  process_gc_list(Free(undefined_name(s1)))
 
   gp = sc->c_objects;
   process_gc_list((c_object_gc_free(sc, s1)) ? (void)(*(c_object_gc_free(sc, s1)))(sc, s1) : (void)(*(c_object_free(sc, s1)))(c_object_value(s1)))
@@ -7340,7 +7356,7 @@ static int64_t gc(s7_scheme *sc)
       {								        \
         p->debugger_bits = 0; p->gc_func = func; p->gc_line = line;	\
         /* if (unchecked_type(p) == T_PAIR) {p->object.cons.opt1 = NULL; p->object.cons.o2.opt2 = NULL; p->object.cons.o3.opt3 = NULL;} */\
-        if (has_odd_bits(p)) {char *s; fprintf(stderr, "odd bits: %s\n", s = describe_type_bits(sc, p)); free(s);} \
+        if (has_odd_bits(p)) {char *s; fprintf(stderr, "odd bits: %s\n", s = describe_type_bits(sc, p)); Free(s);} \
         signed_type(p) = 0;						\
         (*fp++) = p;							\
       }									\
@@ -7563,6 +7579,15 @@ s7_pointer s7_gc_on(s7_scheme *sc, bool on)
   return(s7_make_boolean(sc, on));
 }
 
+void s7_get_heap_stats(s7_scheme *sc, s7_heap_stats *stats)
+{
+  stats->heap_size = sc->heap_size;
+  stats->free_cells = sc->free_heap_top - sc->free_heap;
+  stats->gc_calls = sc->gc_calls;
+  stats->gc_total_freed = sc->gc_total_freed;
+  stats->gc_total_time = (double)(sc->gc_total_time) / ticks_per_second();
+}
+
 #if S7_DEBUGGING
 static void check_free_heap_size_1(s7_scheme *sc, s7_int size, const char *func, int32_t line)
 #define check_free_heap_size(Sc, Size) check_free_heap_size_1(Sc, Size, __func__, __LINE__)
@@ -13907,7 +13932,7 @@ static char *number_to_string_base_10(s7_scheme *sc, s7_pointer obj, s7_int widt
 
       sc->num_to_str[len] = '\0';
       len = catstrs(sc->num_to_str, sc->num_to_str_size, ((imag[0] == '+') || (imag[0] == '-')) ? "" : "+", imag, "i", (char *)NULL);
-      free(imag);
+      Free(imag);
 
       if (width > len)  /* (format #f "~20g" 1+i) */
 	{
@@ -14107,7 +14132,9 @@ char *s7_number_to_string(s7_scheme *sc, s7_pointer obj, s7_int radix)
 {
   s7_int nlen = 0;
   block_t *b = number_to_string_with_radix(sc, obj, radix, 0, 20, 'g', &nlen);  /* (log top 10) so we get all the digits in base 10 (??) */
-  char *str = copy_string_with_length((char *)block_data(b), nlen);
+  char *str = (char *)malloc(nlen + 1); /* caller frees it, so not via allocator */
+  memcpy((void *)str, (void *)block_data(b), nlen);
+  str[nlen] = '\0';
   liberate(sc, b);
   return(str);
 }
@@ -14439,7 +14466,7 @@ static s7_pointer unknown_sharp_constant(s7_scheme *sc, const char *name, s7_poi
 	      buf[len + added_len + 1] = 0;
 	      port_position(pt) += added_len;
 	      res = make_undefined(sc, (const char *)buf);
-	      free(buf);
+	      Free(buf);
 	      return(res);
 	    }}}
   return(make_undefined(sc, name));
@@ -14992,7 +15019,7 @@ static s7_pointer nan1_or_bust(s7_scheme *sc, s7_double x, char *p, char *q, int
 	{
 	  char *ip = copy_string_with_length((const char *)(p + 4), len - 5);
 	  s7_pointer imag = make_atom(sc, ip, radix, NO_SYMBOLS, WITHOUT_OVERFLOW_ERROR);
-	  free(ip);
+	  Free(ip);
 	  if (is_real(imag))
 	    return(make_complex(sc, x, real_to_double(sc, imag, __func__))); /* +nan.0+2/3i etc */
 	}}
@@ -15006,7 +15033,7 @@ static s7_pointer nan2_or_bust(s7_scheme *sc, s7_double x, char *q, int32_t radi
     {
       char *ip = copy_string_with_length((const char *)q, len - 7);
       s7_pointer rl = make_atom(sc, ip, radix, NO_SYMBOLS, WITHOUT_OVERFLOW_ERROR);
-      free(ip);
+      Free(ip);
       if (is_real(rl))
 	return(make_complex(sc, real_to_double(sc, rl, __func__), x));
     }
@@ -15634,7 +15661,7 @@ static void free_rat_locals(s7_scheme *sc)
   mpz_clears(r->i, r->i0, r->i1, r->n, r->p0, r->q0, r->r, r->r1, r->p1, r->q1, r->old_p1, r->old_q1, NULL);
   mpq_clear(r->q);
   mpfr_clears(r->error, r->ux, r->x0, r->x1, r->val, r->e0, r->e1, r->e0p, r->e1p, r->old_e0, r->old_e1, r->old_e0p, NULL);
-  free(r);
+  Free(r);
 }
 
 static s7_pointer big_rationalize(s7_scheme *sc, s7_pointer args)
@@ -30023,7 +30050,7 @@ static s7_pointer load_file_1(s7_scheme *sc, const char *filename)
 	s7_apply_function(sc, sc->load_hook, set_plist_1(sc, s7_make_string(sc, local_file_name)));
       port = read_file(sc, fp, local_file_name, -1, "load"); /* -1 = read entire file into string, this is currently not tweakable */
       port_file_number(port) = remember_file_name(sc, local_file_name);
-      if (filename != local_file_name) free(local_file_name);
+      if (filename != local_file_name) Free(local_file_name);
       set_loader_port(port);
       push_input_port(sc, port);
       return(port);
@@ -34151,7 +34178,7 @@ static void display_fallback(s7_scheme *sc, s7_pointer obj, s7_pointer port, use
       nlen = catstrs_direct(str, "<free cell! ", tmp, ">", (const char *)NULL);
     else nlen = catstrs_direct(str, "<unknown object! ", tmp, ">", (const char *)NULL);
     port_write_string(port)(sc, str, nlen, port);
-    free(tmp);
+    Free(tmp);
     liberate(sc, b);
   }
 #endif
@@ -34675,7 +34702,7 @@ char *s7_object_to_c_string(s7_scheme *sc, s7_pointer obj)
   len = port_position(strport);
   if ((S7_DEBUGGING) && (len == 0)) fprintf(stderr, "%s[%d]: len == 0\n", __func__, __LINE__);
   /* if (len == 0) {close_format_port(sc, strport); return(NULL);} */ /* probably never happens */
-  str = (char *)Malloc(len + 1);
+  str = (char *)malloc(len + 1); /* caller frees it, so not via allocator */
   memcpy((void *)str, (void *)port_data(strport), len);
   str[len] = '\0';
   close_format_port(sc, strport);
@@ -35496,7 +35523,7 @@ static s7_pointer format_to_port_1(s7_scheme *sc, s7_pointer port, const char *s
 			orig_arg = (curly_arg != car(fdat->args)) ? curly_arg : sc->nil;
 			if (curly_len > fdat->curly_len)
 			  {
-			    if (fdat->curly_str) free(fdat->curly_str);
+			    if (fdat->curly_str) Free(fdat->curly_str);
 			    fdat->curly_len = curly_len;
 			    fdat->curly_str = (char *)Malloc(curly_len);
 			  }
@@ -40955,7 +40982,7 @@ static s7_pointer g_multivector(s7_scheme *sc, s7_int dims, s7_pointer data)
       if ((i < (dims - 1)) &&
 	  (!is_pair(x)))
 	{
-	  free(sizes);
+	  Free(sizes);
 	  multivector_error_nr(sc, "we need a list that fully specifies the vector's elements", data);
 	}}
 
@@ -40966,7 +40993,7 @@ static s7_pointer g_multivector(s7_scheme *sc, s7_int dims, s7_pointer data)
   /* now fill the vector checking that all the lists match */
   err = traverse_vector_data(sc, vec, 0, 0, dims, sizes, data);
 
-  free(sizes);
+  Free(sizes);
   s7_gc_unprotect_at(sc, vec_loc);
   if (err < 0)
     multivector_error_nr(sc, (err == MULTIVECTOR_TOO_MANY_ELEMENTS) ? "found too many elements" : "not enough elements found", data);
@@ -43226,6 +43253,12 @@ static hash_entry_t *hash_ci_string(s7_scheme *sc, s7_pointer table, s7_pointer
 /* ---------------- hash eq? ---------------- */
 static s7_int hash_map_nil(s7_scheme *sc, s7_pointer table, s7_pointer key) {return(type(key));}
 
+static s7_int hash_map_c_object(s7_scheme *sc, s7_pointer table, s7_pointer key)
+{
+  /* the type's hash has to agree with its equal? (equivalent? tables still use hash_map_nil) */
+  return((c_object_hash(sc, key)) ? (*(c_object_hash(sc, key)))(sc, key) : type(key));
+}
+
 static s7_int hash_map_eq(s7_scheme *sc, s7_pointer table, s7_pointer key) {return(pointer_map(key));}
 
 static hash_entry_t *hash_eq(s7_scheme *sc, s7_pointer table, s7_pointer key)
@@ -44000,6 +44033,7 @@ static void init_hash_maps(void)
 #endif
 
   for (int32_t i = 0; i < NUM_TYPES; i++) equivalent_hash_map[i] = default_hash_map[i];
+  default_hash_map[T_C_OBJECT] =      hash_map_c_object;
 
   equal_hash_checks[T_SYNTAX] =       hash_equal_syntax;
   equal_hash_checks[T_SYMBOL] =       hash_equal_eq;
@@ -45648,6 +45682,7 @@ void s7_c_type_set_fill(s7_scheme *sc, s7_int tag, s7_pointer (*fill)(s7_scheme
 void s7_c_type_set_reverse(s7_scheme *sc, s7_int tag, s7_pointer (*reverse)(s7_scheme *sc, s7_pointer args))     {sc->c_object_types[tag]->reverse = reverse;}
 void s7_c_type_set_to_list(s7_scheme *sc, s7_int tag, s7_pointer (*to_list)(s7_scheme *sc, s7_pointer args))     {sc->c_object_types[tag]->to_list = to_list;}
 void s7_c_type_set_to_string(s7_scheme *sc, s7_int tag, s7_pointer (*to_string)(s7_scheme *sc, s7_pointer args)) {sc->c_object_types[tag]->to_string = to_string;}
+void s7_c_type_set_hash(s7_scheme *sc, s7_int tag, s7_int (*hash)(s7_scheme *sc, s7_pointer obj))                {sc->c_object_types[tag]->hash = hash;}
 
 void s7_c_type_set_length(s7_scheme *sc, s7_int tag, s7_pointer (*length)(s7_scheme *sc, s7_pointer args))
 {
@@ -45693,6 +45728,7 @@ void s7_c_type_set_setter(s7_scheme *sc, s7_int tag, s7_pointer setter)
 }
 
 void *s7_c_object_value(s7_pointer obj) {return(c_object_value(obj));}
+void *s7_c_object_inline_value(s7_pointer obj) {return((void *)&(c_object_value(obj)));}
 
 void *s7_c_object_value_checked(s7_pointer obj, s7_int type)
 {
@@ -50178,7 +50214,7 @@ static char *stacktrace_walker(s7_scheme *sc, s7_pointer code, s7_pointer e, cha
 			      ": ",
 			      objstr, (const char *)NULL);
 		    }
-		  if (notes) free(notes);
+		  if (notes) Free(notes);
 		  return(str);
 		}}}
       return(notes);
@@ -50308,7 +50344,7 @@ static s7_pointer stacktrace_1(s7_scheme *sc, s7_int frames_max, s7_int code_col
 		      newstr = (char *)block_data(newp);
 
 		      if ((notes) && (notes != newstr) && (is_let(e)) && (e != sc->rootlet))
-			free(notes);
+			Free(notes);
 
 		      newlen = strlen(newstr) + 1 + ((str) ? strlen(str) : 0);
 		      catp = mallocate(sc, newlen);
@@ -51607,7 +51643,7 @@ static noreturn void read_error_1_nr(s7_scheme *sc, const char *errmsg, bool str
 	      string_length(p) = snprintf(msg, len, "%s: %s %s[%u], last top-level form at: %s[%" ld64 "]",
 					  errmsg, (recent_input) ? recent_input : "", port_filename(pt), port_line_number(pt),
 					  sc->current_file, sc->current_line);
-	      if (recent_input) free(recent_input);
+	      if (recent_input) Free(recent_input);
 	      s7_error_nr(sc, sc->read_error_symbol, set_elist_1(sc, p));
 	    }
 	  else
@@ -51621,7 +51657,7 @@ static noreturn void read_error_1_nr(s7_scheme *sc, const char *errmsg, bool str
 					    errmsg, (recent_input) ? recent_input : "",
 					    sc->current_file, sc->current_line);
 	      else string_length(p) = snprintf(msg, len, "%s: %s", errmsg, (recent_input) ? recent_input : "");
-	      if (recent_input) free(recent_input);
+	      if (recent_input) Free(recent_input);
 	      s7_error_nr(sc, sc->read_error_symbol, set_elist_1(sc, p));
 	    }}}
 
@@ -51784,7 +51820,7 @@ static noreturn void missing_close_paren_error_nr(s7_scheme *sc)
 	  nlen = snprintf(msg, len, "missing close paren, %s[%u], last top-level form at %s[%" ld64 "]\n%s",
 			 port_filename(pt), port_line_number(pt),
 			 sc->current_file, sc->current_line, syntax_msg);
-	  free(syntax_msg);
+	  Free(syntax_msg);
 	}
       else nlen = snprintf(msg, len, "missing close paren, %s[%u], last top-level form at %s[%" ld64 "]",
 			  port_filename(pt), port_line_number(pt),
@@ -51799,7 +51835,7 @@ static noreturn void missing_close_paren_error_nr(s7_scheme *sc)
       s7_pointer p = make_empty_string(sc, len, '\0');
       char *msg = string_value(p);
       len = catstrs(msg, len, "missing close paren\n", syntax_msg, "\n", (char *)NULL);
-      free(syntax_msg);
+      Free(syntax_msg);
       string_length(p) = len;
       s7_error_nr(sc, sc->read_error_symbol, set_elist_1(sc, p));
     }
@@ -94632,15 +94668,32 @@ s7_scheme *s7_init(void)
   /* cell size: 48, 120 if debugging, block size: 40, opt: 128 or 280 */
 #endif
 
+  live_interpreters++;
   return(sc);
 }
 
+s7_scheme *s7_init_with_allocator(const s7_allocator *a)
+{
+  if (!a) a = &libc_allocator;
+  if ((live_interpreters > 0) &&
+      ((a->malloc != allocator.malloc) || (a->calloc != allocator.calloc) || (a->realloc != allocator.realloc) ||
+       (a->free != allocator.free) || (a->data != allocator.data)))
+    {
+      /* the live interpreters' memory would be freed through the new hooks */
+      fprintf(stderr, "s7_init_with_allocator: %d interpreter%s still using another allocator\n",
+	      live_interpreters, (live_interpreters == 1) ? " is" : "s are");
+      return(NULL);
+    }
+  allocator = *a;
+  return(s7_init());
+}
+
 
 /* -------------------------------- s7_free -------------------------------- */
 static void gc_list_free(gc_list_t *g)
 {
-  free(g->list);
-  free(g);
+  Free(g->list);
+  Free(g);
 }
 
 void s7_free(s7_scheme *sc)
@@ -94668,14 +94721,14 @@ void s7_free(s7_scheme *sc)
   gp = sc->vectors;
   for (i = 0; i < gp->loc; i++)
     if (block_index(unchecked_vector_block(gp->list[i])) == TOP_BLOCK_LIST)
-      free(block_data(unchecked_vector_block(gp->list[i])));
+      Free(block_data(unchecked_vector_block(gp->list[i])));
   gc_list_free(gp);
   gc_list_free(sc->multivectors); /* I assume vector_dimension_info won't need 131072 bytes */
 
   gp = sc->strings;
   for (i = 0; i < gp->loc; i++)
     if (block_index(unchecked_string_block(gp->list[i])) == TOP_BLOCK_LIST)
-      free(block_data(unchecked_string_block(gp->list[i])));
+      Free(block_data(unchecked_string_block(gp->list[i])));
   gc_list_free(gp);
 
   gp = sc->output_ports;
@@ -94683,7 +94736,7 @@ void s7_free(s7_scheme *sc)
     {
       if ((unchecked_port_data_block(gp->list[i])) &&
 	  (block_index(unchecked_port_data_block(gp->list[i])) == TOP_BLOCK_LIST))
-	free(block_data(unchecked_port_data_block(gp->list[i])));   /* the file contents, port_block is other stuff */
+	Free(block_data(unchecked_port_data_block(gp->list[i])));   /* the file contents, port_block is other stuff */
       if ((is_file_port(gp->list[i])) &&
 	  (!port_is_closed(gp->list[i])))
 	fclose(port_file(gp->list[i]));
@@ -94694,38 +94747,38 @@ void s7_free(s7_scheme *sc)
   for (i = 0; i < gp->loc; i++)
     if ((unchecked_port_data_block(gp->list[i])) &&
 	(block_index(unchecked_port_data_block(gp->list[i])) == TOP_BLOCK_LIST))
-      free(block_data(unchecked_port_data_block(gp->list[i])));    /* the file contents, port_block is other stuff */
+      Free(block_data(unchecked_port_data_block(gp->list[i])));    /* the file contents, port_block is other stuff */
   gc_list_free(gp);
   gc_list_free(sc->input_string_ports); /* port_data_block is null, port_block is the const char* data, so I assume it is handled elsewhere */
 
   gp = sc->hash_tables;
   for (i = 0; i < gp->loc; i++)
     if (block_index(unchecked_hash_table_block(gp->list[i])) == TOP_BLOCK_LIST)
-      free(block_data(unchecked_hash_table_block(gp->list[i])));
+      Free(block_data(unchecked_hash_table_block(gp->list[i])));
   gc_list_free(gp);
 
 #if WITH_GMP
   /* free lists */
-  {bigint *p, *np; for (p = sc->bigints; p; p = np) {mpz_clear(p->n); np = p->nxt; free(p);}}
-  {bigrat *p, *np; for (p = sc->bigrats; p; p = np) {mpq_clear(p->q); np = p->nxt; free(p);}}
-  {bigflt *p, *np; for (p = sc->bigflts; p; p = np) {mpfr_clear(p->x); np = p->nxt; free(p);}}
-  {bigcmp *p, *np; for (p = sc->bigcmps; p; p = np) {mpc_clear(p->z); np = p->nxt; free(p);}}
+  {bigint *p, *np; for (p = sc->bigints; p; p = np) {mpz_clear(p->n); np = p->nxt; Free(p);}}
+  {bigrat *p, *np; for (p = sc->bigrats; p; p = np) {mpq_clear(p->q); np = p->nxt; Free(p);}}
+  {bigflt *p, *np; for (p = sc->bigflts; p; p = np) {mpfr_clear(p->x); np = p->nxt; Free(p);}}
+  {bigcmp *p, *np; for (p = sc->bigcmps; p; p = np) {mpc_clear(p->z); np = p->nxt; Free(p);}}
 
   /* in-use lists */
   gp = sc->big_integers;
-  for (i = 0; i < gp->loc; i++) {bigint *p; p = big_integer_bgi(gp->list[i]); mpz_clear(p->n); free(p);}
+  for (i = 0; i < gp->loc; i++) {bigint *p; p = big_integer_bgi(gp->list[i]); mpz_clear(p->n); Free(p);}
   gc_list_free(gp);
 
   gp = sc->big_ratios;
-  for (i = 0; i < gp->loc; i++) {bigrat *p; p = big_ratio_bgr(gp->list[i]); mpq_clear(p->q); free(p);}
+  for (i = 0; i < gp->loc; i++) {bigrat *p; p = big_ratio_bgr(gp->list[i]); mpq_clear(p->q); Free(p);}
   gc_list_free(gp);
 
   gp = sc->big_reals;
-  for (i = 0; i < gp->loc; i++) {bigflt *p; p = big_real_bgf(gp->list[i]); mpfr_clear(p->x); free(p);}
+  for (i = 0; i < gp->loc; i++) {bigflt *p; p = big_real_bgf(gp->list[i]); mpfr_clear(p->x); Free(p);}
   gc_list_free(gp);
 
   gp = sc->big_complexes;
-  for (i = 0; i < gp->loc; i++) {bigcmp *p; p = big_complex_bgc(gp->list[i]); mpc_clear(p->z); free(p);}
+  for (i = 0; i < gp->loc; i++) {bigcmp *p; p = big_complex_bgc(gp->list[i]); mpc_clear(p->z); Free(p);}
   gc_list_free(gp);
 
   gp = sc->big_random_states;
@@ -94744,10 +94797,10 @@ void s7_free(s7_scheme *sc)
   /* I claim the leftovers (864 bytes, all from mpfr_cosh) are gmp's fault */
 #endif
 
-  free(undefined_name(sc->undefined));
+  Free(undefined_name(sc->undefined));
   gp = sc->undefineds;
   for (i = 0; i < gp->loc; i++)
-    free(undefined_name(gp->list[i]));
+    Free(undefined_name(gp->list[i]));
   gc_list_free(gp);
 
   gc_list_free(sc->gensyms);
@@ -94756,77 +94809,78 @@ void s7_free(s7_scheme *sc)
   gc_list_free(sc->weak_hash_iterators);
   gc_list_free(sc->opt1_funcs);
 
-  free(port_port(sc->standard_output));
-  free(port_port(sc->standard_error));
-  free(port_port(sc->standard_input));
+  Free(port_port(sc->standard_output));
+  Free(port_port(sc->standard_error));
+  Free(port_port(sc->standard_input));
 
-  if (sc->autoload_names) free(sc->autoload_names);
-  if (sc->autoload_names_sizes) free(sc->autoload_names_sizes);
-  if (sc->autoloaded_already) free(sc->autoloaded_already);
+  if (sc->autoload_names) Free(sc->autoload_names);
+  if (sc->autoload_names_sizes) Free(sc->autoload_names_sizes);
+  if (sc->autoloaded_already) Free(sc->autoloaded_already);
 
   for (block_t *top = sc->block_lists[TOP_BLOCK_LIST]; top; top = block_next(top))
     if (block_data(top))
-      free(block_data(top));
+      Free(block_data(top));
 
   for (i = 0; i < sc->saved_pointers_loc; i++)
-    free(sc->saved_pointers[i]);
-  free(sc->saved_pointers);
+    Free(sc->saved_pointers[i]);
+  Free(sc->saved_pointers);
 
   {
     gc_obj_t *g, *gnxt;
     heap_block_t *hpnxt;
-    for (g = sc->permanent_lets; g; g = gnxt)    {gnxt = g->nxt; free(g);}
-    for (g = sc->permanent_objects; g; g = gnxt) {gnxt = g->nxt; free(g);}
-    for (heap_block_t *hp = sc->heap_blocks; hp; hp = hpnxt) {hpnxt = hp->next; free(hp);}
+    for (g = sc->permanent_lets; g; g = gnxt)    {gnxt = g->nxt; Free(g);}
+    for (g = sc->permanent_objects; g; g = gnxt) {gnxt = g->nxt; Free(g);}
+    for (heap_block_t *hp = sc->heap_blocks; hp; hp = hpnxt) {hpnxt = hp->next; Free(hp);}
   }
 
-  free(sc->heap);
-  free(sc->free_heap);
-  free(vector_elements(sc->symbol_table)); /* alloc'd directly, not via block */
-  free(sc->symbol_table);
-  free(sc->unlet);
-  free(sc->setters);
-  free(sc->op_stack);
-  if (sc->tree_pointers) free(sc->tree_pointers);
-  free(sc->num_to_str);
-  free(sc->protected_objects_free_list);
-  if (sc->read_line_buf) free(sc->read_line_buf);
-  free(sc->strbuf);
-  free(sc->circle_info->objs);
-  free(sc->circle_info->refs);
-  free(sc->circle_info->defined);
-  free(sc->circle_info);
-  if (sc->file_names) free(sc->file_names);
-  free(sc->unentry);
-  free(sc->input_port_stack);
-  if (sc->typnam) free(sc->typnam);
+  Free(sc->heap);
+  Free(sc->free_heap);
+  Free(vector_elements(sc->symbol_table)); /* alloc'd directly, not via block */
+  Free(sc->symbol_table);
+  Free(sc->unlet);
+  Free(sc->setters);
+  Free(sc->op_stack);
+  if (sc->tree_pointers) Free(sc->tree_pointers);
+  Free(sc->num_to_str);
+  Free(sc->protected_objects_free_list);
+  if (sc->read_line_buf) Free(sc->read_line_buf);
+  Free(sc->strbuf);
+  Free(sc->circle_info->objs);
+  Free(sc->circle_info->refs);
+  Free(sc->circle_info->defined);
+  Free(sc->circle_info);
+  if (sc->file_names) Free(sc->file_names);
+  Free(sc->unentry);
+  Free(sc->input_port_stack);
+  if (sc->typnam) Free(sc->typnam);
 
   for (i = 0; i < sc->num_fdats; i++)
     if (sc->fdats[i])                 /* init val is NULL */
       {
 	if (sc->fdats[i]->curly_str)
-	  free(sc->fdats[i]->curly_str);
-	free(sc->fdats[i]);
+	  Free(sc->fdats[i]->curly_str);
+	Free(sc->fdats[i]);
       }
-  free(sc->fdats);
+  Free(sc->fdats);
 
   if (sc->profile_data)
     {
-      free(sc->profile_data->funcs);
-      free(sc->profile_data->let_names);
-      free(sc->profile_data->files);
-      free(sc->profile_data->lines);
-      free(sc->profile_data->excl);
-      free(sc->profile_data->timing_data);
-      free(sc->profile_data);
+      Free(sc->profile_data->funcs);
+      Free(sc->profile_data->let_names);
+      Free(sc->profile_data->files);
+      Free(sc->profile_data->lines);
+      Free(sc->profile_data->excl);
+      Free(sc->profile_data->timing_data);
+      Free(sc->profile_data);
     }
   if (sc->c_object_types)
     {
       for (i = 0; i < sc->num_c_object_types; i++)
-	free(sc->c_object_types[i]);
-      free(sc->c_object_types);
+	Free(sc->c_object_types[i]);
+      Free(sc->c_object_types);
     }
-  free(sc);
+  live_interpreters--;
+  Free(sc);
 }
 
 
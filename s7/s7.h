@@ -7,6 +7,7 @@
 #define S7_MINOR_VERSION 4
 
 #include <stdint.h>           /* for int64_t */
+#include <stddef.h>           /* for size_t */
 
 typedef int64_t s7_int;
 typedef double s7_double;
@@ -43,6 +44,27 @@ s7_scheme *s7_init(void);
    * s7_pointer is a Scheme object of any (Scheme) type
    * s7_init creates the interpreter.
    */
+
+typedef struct s7_allocator {
+  void *(*malloc)(void *data, size_t bytes);
+  void *(*calloc)(void *data, size_t count, size_t size);
+  void *(*realloc)(void *data, void *ptr, size_t bytes);
+  void (*free)(void *data, void *ptr);
+  void *data;                                                        /* passed to each of the above */
+} s7_allocator;
+
+s7_scheme *s7_init_with_allocator(const s7_allocator *a);
+
+  /* s7_init_with_allocator routes all of s7's own memory through a (which is copied; NULL means libc).
+   *   The allocator is process-wide, not per interpreter: set it before the first s7_init, and keep it
+   *   (and whatever a->data points to) alive until the last s7_free.  While any interpreter is live,
+   *   s7_init_with_allocator with different hooks returns NULL instead of re-routing its frees.
+   *   s7 is single-threaded, so the functions are never called concurrently by s7 itself.
+   *   Memory that crosses the API stays with libc:
+   *     the strings the caller frees: s7_object_to_c_string, s7_number_to_string
+   *     the memory s7 frees for the caller: the data of s7_make_float_vector_wrapper with free_data,
+   *       and the strings returned by deprecated c_object print functions
+   */
 void s7_free(s7_scheme *sc);
 
 typedef s7_pointer (*s7_function)(s7_scheme *sc, s7_pointer args);   /* that is, obj = func(s7, args) -- args is a list of arguments */
@@ -143,6 +165,16 @@ bool s7_set_history_enabled(s7_scheme *sc, bool enabled);
 
 s7_pointer s7_gc_on(s7_scheme *sc, bool on);                         /* (gc on) */
 
+typedef struct s7_heap_stats {
+  s7_int heap_size;                                                  /* cells */
+  s7_int free_cells;
+  s7_int gc_calls;
+  s7_int gc_total_freed;                                             /* cells freed by all GCs so far */
+  s7_double gc_total_time;                                           /* seconds */
+} s7_heap_stats;
+
+void s7_get_heap_stats(s7_scheme *sc, s7_heap_stats *stats);         /* like (*s7* 'memory-usage) but allocates nothing */
+
 s7_int s7_gc_protect(s7_scheme *sc, s7_pointer x);
 void s7_gc_unprotect_at(s7_scheme *sc, s7_int loc);
 s7_pointer s7_gc_protected_at(s7_scheme *sc, s7_int loc);
@@ -290,7 +322,7 @@ bool s7_is_complex(s7_pointer arg);                                         /* (
 s7_pointer s7_make_complex(s7_scheme *sc, s7_double a, s7_double b);        /* returns the Scheme object a+bi */
 s7_double s7_real_part(s7_pointer z);                                       /* (real-part z) */
 s7_double s7_imag_part(s7_pointer z);                                       /* (imag-part z) */
-char *s7_number_to_string(s7_scheme *sc, s7_pointer obj, s7_int radix);     /* (number->string obj radix) */
+char *s7_number_to_string(s7_scheme *sc, s7_pointer obj, s7_int radix);     /* (number->string obj radix) -- free the string */
 
 bool s7_is_vector(s7_pointer p);                                            /* (vector? p) */
 s7_int s7_vector_length(s7_pointer vec);                                    /* (vector-length vec) */
@@ -647,6 +679,10 @@ void s7_mark(s7_pointer p);
 bool s7_is_c_object(s7_pointer p);
 s7_int s7_c_object_type(s7_pointer obj);
 void *s7_c_object_value(s7_pointer obj);
+void *s7_c_object_inline_value(s7_pointer obj);
+  /* address of the value field itself: a type whose data fits in sizeof(void *) bytes can live in the cell
+   *   (make it with s7_make_c_object_without_gc, no free function needed)
+   */
 void *s7_c_object_value_checked(s7_pointer obj, s7_int type);
 s7_pointer s7_make_c_object(s7_scheme *sc, s7_int type, void *value);
 s7_pointer s7_make_c_object_with_let(s7_scheme *sc, s7_int type, void *value, s7_pointer let);
@@ -676,6 +712,7 @@ void s7_c_type_set_fill         (s7_scheme *sc, s7_int tag, s7_pointer (*fill)
 void s7_c_type_set_reverse      (s7_scheme *sc, s7_int tag, s7_pointer (*reverse)   (s7_scheme *sc, s7_pointer args));
 void s7_c_type_set_to_list      (s7_scheme *sc, s7_int tag, s7_pointer (*to_list)   (s7_scheme *sc, s7_pointer args));
 void s7_c_type_set_to_string    (s7_scheme *sc, s7_int tag, s7_pointer (*to_string) (s7_scheme *sc, s7_pointer args));
+void s7_c_type_set_hash         (s7_scheme *sc, s7_int tag, s7_int     (*hash)      (s7_scheme *sc, s7_pointer obj));
 void s7_c_type_set_getter       (s7_scheme *sc, s7_int tag, s7_pointer getter);
 void s7_c_type_set_setter       (s7_scheme *sc, s7_int tag, s7_pointer setter);
 /* For the copy function, either the first or second argument can be a c-object of the given type. */
@@ -692,6 +729,7 @@ void s7_c_type_set_setter       (s7_scheme *sc, s7_int tag, s7_pointer setter);
    *   equal:         compare two objects of this type; (equal? obj1 obj2) -- this is the old form
    *   is_equal:      compare objects as in equal? -- this is the new form of equal?
    *   is_equivalent: compare objects as in equivalent?
+   *   hash:          hash an object by content for equal? hash-tables; objects that are equal? must hash the same
    *   ref:           a function that is called whenever an object of this type
    *                  occurs in the function position (at the car of a list; the rest of the list
    *                  is passed to the ref function as the arguments: (obj ...))
@@ -0,0 +1,683 @@
+// -*- c++ -*-
+#pragma once
+
+#include "misc.h"
+#include <string.h>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Lane types: the handful of instructions the vector math below is built
+// from. Scalar is one f32, Sse four (any x86-64), Avx eight (-mavx). Wide
+// is the widest one the build allows; the choice is made at compile time.
+//
+// Kernels are written once against the vector math and run twice: Wide
+// over the bulk of the arrays, Scalar over the remaining tail:
+//
+//   template <typename L>
+//   static u32 normalize_k(f32* xs, f32* ys, u32 i, u32 n)
+//   {
+//     for (; i + L::width <= n; i += L::width) {
+//       normalized(Vec2x<L>::load(xs + i, ys + i)).store(xs + i, ys + i);
+//     }
+//     return i;
+//   }
+//
+//   u32 i = normalize_k<Wide>(xs, ys, 0, n);
+//   normalize_k<Scalar>(xs, ys, i, n);
+
+struct Scalar
+{
+  typedef f32 T;
+  typedef bool Mask;
+  static const u32 width = 1;
+  static inline T load(const f32* p) { return *p; }
+  static inline void store(f32* p, T v) { *p = v; }
+  static inline T splat(f32 v) { return v; }
+  static inline T add(T a, T b) { return a + b; }
+  static inline T sub(T a, T b) { return a - b; }
+  static inline T mul(T a, T b) { return a * b; }
+  static inline T div(T a, T b) { return a / b; }
+  static inline T min(T a, T b) { return a < b ? a : b; }
+  static inline T max(T a, T b) { return a > b ? a : b; }
+  static inline T sqrt(T a) { return sqrtf(a); }
+  static inline T abs(T a) { return fabsf(a); }
+  static inline T trunc(T a) { return f32(i32(a)); }
+  static inline T gather(const f32* p, T i) { return p[i32(i)]; }
+  static inline Mask lt(T a, T b) { return a < b; }
+  static inline Mask le(T a, T b) { return a <= b; }
+  static inline Mask both(Mask a, Mask b) { return a & b; }
+  static inline Mask either(Mask a, Mask b) { return a | b; }
+  static inline T select(Mask m, T a, T b)    // m ? a : b, without a branch
+  {
+    u32 ua, ub;
+    memcpy(&ua, &a, 4);
+    memcpy(&ub, &b, 4);
+    const u32 r = (ua & -u32(m)) | (ub & (u32(m) - 1));
+    memcpy(&a, &r, 4);
+    return a;
+  }
+  static inline u32 bits(Mask m) { return m; }                      // lane i in bit i
+};
+
+#if defined(__SSE2__)
+struct Sse
+{
+  typedef __m128 T;
+  typedef __m128 Mask;
+  static const u32 width = 4;
+  static inline T load(const f32* p) { return _mm_loadu_ps(p); }
+  static inline void store(f32* p, T v) { _mm_storeu_ps(p, v); }
+  static inline T splat(f32 v) { return _mm_set1_ps(v); }
+  static inline T add(T a, T b) { return _mm_add_ps(a, b); }
+  static inline T sub(T a, T b) { return _mm_sub_ps(a, b); }
+  static inline T mul(T a, T b) { return _mm_mul_ps(a, b); }
+  static inline T div(T a, T b) { return _mm_div_ps(a, b); }
+  static inline T min(T a, T b) { return _mm_min_ps(a, b); }
+  static inline T max(T a, T b) { return _mm_max_ps(a, b); }
+  static inline T sqrt(T a) { return _mm_sqrt_ps(a); }
+  static inline T abs(T a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+  static inline T trunc(T a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+  static inline T gather(const f32* p, T i)
+  {
+    alignas(16) i32 k[4];
+    _mm_store_si128((__m128i*)k, _mm_cvttps_epi32(i));
+    return _mm_setr_ps(p[k[0]], p[k[1]], p[k[2]], p[k[3]]);
+  }
+  static inline Mask lt(T a, T b) { return _mm_cmplt_ps(a, b); }
+  static inline Mask le(T a, T b) { return _mm_cmple_ps(a, b); }
+  static inline Mask both(Mask a, Mask b) { return _mm_and_ps(a, b); }
+  static inline Mask either(Mask a, Mask b) { return _mm_or_ps(a, b); }
+  static inline T select(Mask m, T a, T b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+  static inline u32 bits(Mask m) { return _mm_movemask_ps(m); }
+};
+#endif
+
+#if defined(__AVX__)
+struct Avx
+{
+  typedef __m256 T;
+  typedef __m256 Mask;
+  static const u32 width = 8;
+  static inline T load(const f32* p) { return _mm256_loadu_ps(p); }
+  static inline void store(f32* p, T v) { _mm256_storeu_ps(p, v); }
+  static inline T splat(f32 v) { return _mm256_set1_ps(v); }
+  static inline T add(T a, T b) { return _mm256_add_ps(a, b); }
+  static inline T sub(T a, T b) { return _mm256_sub_ps(a, b); }
+  static inline T mul(T a, T b) { return _mm256_mul_ps(a, b); }
+  static inline T div(T a, T b) { return _mm256_div_ps(a, b); }
+  static inline T min(T a, T b) { return _mm256_min_ps(a, b); }
+  static inline T max(T a, T b) { return _mm256_max_ps(a, b); }
+  static inline T sqrt(T a) { return _mm256_sqrt_ps(a); }
+  static inline T abs(T a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+  static inline T trunc(T a) { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+  static inline T gather(const f32* p, T i)
+  {
+#if defined(__AVX2__)
+    return _mm256_i32gather_ps(p, _mm256_cvttps_epi32(i), 4);
+#else
+    alignas(32) i32 k[8];
+    _mm256_store_si256((__m256i*)k, _mm256_cvttps_epi32(i));
+    return _mm256_setr_ps(p[k[0]], p[k[1]], p[k[2]], p[k[3]], p[k[4]], p[k[5]], p[k[6]], p[k[7]]);
+#endif
+  }
+  static inline Mask lt(T a, T b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static inline Mask le(T a, T b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+  static inline Mask both(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+  static inline Mask either(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+  static inline T select(Mask m, T a, T b) { return _mm256_blendv_ps(b, a, m); }
+  static inline u32 bits(Mask m) { return _mm256_movemask_ps(m); }
+};
+typedef Avx Wide;
+#elif defined(__SSE2__)
+typedef Sse Wide;
+#else
+typedef Scalar Wide;
+#endif
+
+// L::width f32s, with the arithmetic and the misc.h helpers that make
+// sense lane-wise. Comparisons give a Maskx; select() picks per lane.
+
+template <typename L>
+struct Maskx
+{
+  typename L::Mask m;
+
+  explicit Maskx(typename L::Mask m) : m(m) {}
+
+  u32 bits() const
+  {
+    return L::bits(m);
+  }
+
+  bool any() const
+  {
+    return bits() != 0;
+  }
+
+  bool all() const
+  {
+    return bits() == (1u << L::width) - 1;
+  }
+};
+
+template <typename L>
+inline Maskx<L> operator&(const Maskx<L>& a, const Maskx<L>& b)
+{
+  return Maskx<L>(L::both(a.m, b.m));
+}
+
+template <typename L>
+inline Maskx<L> operator|(const Maskx<L>& a, const Maskx<L>& b)
+{
+  return Maskx<L>(L::either(a.m, b.m));
+}
+
+template <typename L>
+struct F32x
+{
+  static const u32 width = L::width;
+  typename L::T v;
+
+  F32x() {}
+  explicit F32x(typename L::T v) : v(v) {}
+
+  static F32x splat(f32 a)
+  {
+    return F32x(L::splat(a));
+  }
+
+  static F32x load(const f32* p)
+  {
+    return F32x(L::load(p));
+  }
+
+  // table[index] per lane; index holds whole numbers, e.g. from trunc()
+  static F32x gather(const f32* table, const F32x& index)
+  {
+    return F32x(L::gather(table, index.v));
+  }
+
+  // from a float-vector
+  static F32x load(const f64* p)
+  {
+    f32 tmp[L::width];
+    for (u32 j = 0; j < L::width; j++) {
+      tmp[j] = p[j];
+    }
+    return load(tmp);
+  }
+
+  void store(f32* p) const
+  {
+    L::store(p, v);
+  }
+
+  void store(f64* p) const
+  {
+    f32 tmp[L::width];
+    store(tmp);
+    for (u32 j = 0; j < L::width; j++) {
+      p[j] = tmp[j];
+    }
+  }
+};
+
+template <typename L>
+inline F32x<L> operator+(const F32x<L>& a, const F32x<L>& b)
+{
+  return F32x<L>(L::add(a.v, b.v));
+}
+
+template <typename L>
+inline F32x<L> operator-(const F32x<L>& a, const F32x<L>& b)
+{
+  return F32x<L>(L::sub(a.v, b.v));
+}
+
+template <typename L>
+inline F32x<L> operator-(const F32x<L>& a)
+{
+  return F32x<L>(L::sub(L::splat(0.0f), a.v));
+}
+
+template <typename L>
+inline F32x<L> operator*(const F32x<L>& a, const F32x<L>& b)
+{
+  return F32x<L>(L::mul(a.v, b.v));
+}
+
+template <typename L>
+inline F32x<L> operator/(const F32x<L>& a, const F32x<L>& b)
+{
+  return F32x<L>(L::div(a.v, b.v));
+}
+
+template <typename L>
+inline Maskx<L> operator<(const F32x<L>& a, const F32x<L>& b)
+{
+  return Maskx<L>(L::lt(a.v, b.v));
+}
+
+template <typename L>
+inline Maskx<L> operator<=(const F32x<L>& a, const F32x<L>& b)
+{
+  return Maskx<L>(L::le(a.v, b.v));
+}
+
+template <typename L>
+inline Maskx<L> operator>(const F32x<L>& a, const F32x<L>& b)
+{
+  return Maskx<L>(L::lt(b.v, a.v));
+}
+
+template <typename L>
+inline Maskx<L> operator>=(const F32x<L>& a, const F32x<L>& b)
+{
+  return Maskx<L>(L::le(b.v, a.v));
+}
+
+// m ? a : b, lane by lane
+template <typename L>
+inline F32x<L> select(const Maskx<L>& m, const F32x<L>& a, const F32x<L>& b)
+{
+  return F32x<L>(L::select(m.m, a.v, b.v));
+}
+
+template <typename L>
+inline F32x<L> min(const F32x<L>& a, const F32x<L>& b)
+{
+  return F32x<L>(L::min(a.v, b.v));
+}
+
+template <typename L>
+inline F32x<L> max(const F32x<L>& a, const F32x<L>& b)
+{
+  return F32x<L>(L::max(a.v, b.v));
+}
+
+template <typename L>
+inline F32x<L> sqrt(const F32x<L>& a)
+{
+  return F32x<L>(L::sqrt(a.v));
+}
+
+template <typename L>
+inline F32x<L> abs(const F32x<L>& a)
+{
+  return F32x<L>(L::abs(a.v));
+}
+
+// toward zero, for |a| < 2^31
+template <typename L>
+inline F32x<L> trunc(const F32x<L>& a)
+{
+  return F32x<L>(L::trunc(a.v));
+}
+
+template <typename L>
+inline F32x<L> sqr(const F32x<L>& a)
+{
+  return a * a;
+}
+
+template <typename L>
+inline F32x<L> clamp(const F32x<L>& x, const F32x<L>& min, const F32x<L>& max)
+{
+  return F32x<L>(L::max(L::min(x.v, max.v), min.v));
+}
+
+template <typename L>
+inline F32x<L> clamp01(const F32x<L>& x)
+{
+  return clamp(x, F32x<L>::splat(0.0f), F32x<L>::splat(1.0f));
+}
+
+template <typename L>
+inline F32x<L> lerp(const F32x<L>& a, const F32x<L>& b, const F32x<L>& t)
+{
+  return a * (F32x<L>::splat(1.0f) - t) + b * t;
+}
+
+template <typename L>
+inline Maskx<L> fuzzy_zero(const F32x<L>& a)
+{
+  return abs(a) < F32x<L>::splat(FLT_EPSILON);
+}
+
+// the same test as fuzzy_equal(f32, f32): absolute near zero, relative
+// elsewhere
+template <typename L>
+inline Maskx<L> fuzzy_equal(const F32x<L>& a, const F32x<L>& b)
+{
+  const F32x<L> eps = F32x<L>::splat(FLT_EPSILON);
+  const F32x<L> diff = abs(a - b);
+  return (diff < eps) | (diff < eps * (abs(a) + abs(b)));
+}
+
+template <typename L>
+inline F32x<L> ease_linear(const F32x<L>& t)
+{
+  return t;
+}
+
+template <typename L>
+inline F32x<L> ease_cubic_in(const F32x<L>& t)
+{
+  return t * t * t;
+}
+
+template <typename L>
+inline F32x<L> ease_cubic_out(const F32x<L>& t)
+{
+  const F32x<L> u = t - F32x<L>::splat(1.0f);
+  return F32x<L>::splat(1.0f) + u * u * u;
+}
+
+template <typename L>
+inline F32x<L> ease_cubic_in_out(const F32x<L>& t)
+{
+  const F32x<L> u = t - F32x<L>::splat(1.0f);
+  const F32x<L> four = F32x<L>::splat(4.0f);
+  return select(t < F32x<L>::splat(0.5f), four * t * t * t, F32x<L>::splat(1.0f) + four * u * u * u);
+}
+
+// L::width vec2s, mirroring the Vec2 functions in misc.h. Stored as
+// separate x and y lanes, so it loads straight from a Vec2Buffer.
+
+template <typename L>
+struct Vec2x
+{
+  typedef F32x<L> F;
+  static const u32 width = L::width;
+  F x, y;
+
+  Vec2x() {}
+  Vec2x(const F& x, const F& y) : x(x), y(y) {}
+
+  static Vec2x splat(const Vec2& v)
+  {
+    return Vec2x(F::splat(v.x), F::splat(v.y));
+  }
+
+  static Vec2x load(const f32* xs, const f32* ys)
+  {
+    return Vec2x(F::load(xs), F::load(ys));
+  }
+
+  // from a float-vector of x y pairs
+  static Vec2x load_pairs(const f64* p)
+  {
+    f32 xs[L::width], ys[L::width];
+    for (u32 j = 0; j < L::width; j++) {
+      xs[j] = p[2 * j];
+      ys[j] = p[2 * j + 1];
+    }
+    return load(xs, ys);
+  }
+
+  void store(f32* xs, f32* ys) const
+  {
+    x.store(xs);
+    y.store(ys);
+  }
+
+  void store_pairs(f64* p) const
+  {
+    f32 xs[L::width], ys[L::width];
+    store(xs, ys);
+    for (u32 j = 0; j < L::width; j++) {
+      p[2 * j] = xs[j];
+      p[2 * j + 1] = ys[j];
+    }
+  }
+};
+
+template <typename L>
+inline Vec2x<L> operator+(const Vec2x<L>& a, const Vec2x<L>& b)
+{
+  return Vec2x<L>(a.x + b.x, a.y + b.y);
+}
+
+template <typename L>
+inline Vec2x<L> operator-(const Vec2x<L>& a, const Vec2x<L>& b)
+{
+  return Vec2x<L>(a.x - b.x, a.y - b.y);
+}
+
+template <typename L>
+inline Vec2x<L> operator-(const Vec2x<L>& a)
+{
+  return Vec2x<L>(-a.x, -a.y);
+}
+
+template <typename L>
+inline Vec2x<L> operator*(const Vec2x<L>& a, const F32x<L>& s)
+{
+  return Vec2x<L>(a.x * s, a.y * s);
+}
+
+template <typename L>
+inline Vec2x<L> operator*(const F32x<L>& s, const Vec2x<L>& a)
+{
+  return a * s;
+}
+
+template <typename L>
+inline Vec2x<L> operator/(const Vec2x<L>& a, const F32x<L>& s)
+{
+  return Vec2x<L>(a.x / s, a.y / s);
+}
+
+template <typename L>
+inline F32x<L> dot(const Vec2x<L>& a, const Vec2x<L>& b)
+{
+  return a.x * b.x + a.y * b.y;
+}
+
+template <typename L>
+inline F32x<L> cross(const Vec2x<L>& a, const Vec2x<L>& b)
+{
+  return a.x * b.y - a.y * b.x;
+}
+
+template <typename L>
+inline F32x<L> length2(const Vec2x<L>& a)
+{
+  return dot(a, a);
+}
+
+template <typename L>
+inline F32x<L> length(const Vec2x<L>& a)
+{
+  return sqrt(length2(a));
+}
+
+template <typename L>
+inline F32x<L> distance(const Vec2x<L>& a, const Vec2x<L>& b)
+{
+  return length(a - b);
+}
+
+template <typename L>
+inline Vec2x<L> perp(const Vec2x<L>& a)
+{
+  return Vec2x<L>(-a.y, a.x);
+}
+
+// zero vectors stay zero, as in normalized(const Vec2&)
+template <typename L>
+inline Vec2x<L> normalized(const Vec2x<L>& a)
+{
+  typedef F32x<L> F;
+  const F len = length(a);
+  const F inv = select(fuzzy_zero(len), F::splat(0.0f), F::splat(1.0f) / len);
+  return a * inv;
+}
+
+// by the angle whose sine and cosine are s and c, lane by lane
+template <typename L>
+inline Vec2x<L> rotate(const Vec2x<L>& v, const F32x<L>& s, const F32x<L>& c)
+{
+  return Vec2x<L>(v.x * c - v.y * s, v.y * c + v.x * s);
+}
+
+template <typename L>
+inline Vec2x<L> rotate(const Vec2x<L>& v, f32 angle)
+{
+  f32 s, c;
+  sin_cos(angle, &s, &c);
+  return rotate(v, F32x<L>::splat(s), F32x<L>::splat(c));
+}
+
+template <typename L>
+inline Vec2x<L> lerp(const Vec2x<L>& a, const Vec2x<L>& b, const F32x<L>& t)
+{
+  return Vec2x<L>(lerp(a.x, b.x, t), lerp(a.y, b.y, t));
+}
+
+template <typename L>
+inline Vec2x<L> clamp(const Vec2x<L>& v, const Vec2x<L>& min, const Vec2x<L>& max)
+{
+  return Vec2x<L>(clamp(v.x, min.x, max.x), clamp(v.y, min.y, max.y));
+}
+
+template <typename L>
+inline Maskx<L> fuzzy_equal(const Vec2x<L>& a, const Vec2x<L>& b)
+{
+  return fuzzy_equal(a.x, b.x) & fuzzy_equal(a.y, b.y);
+}
+
+// Fast trig, lane-wise and branch free below FAST_TRIG_RANGE, with
+// scalar forms in misc.h.
+// Max error against double precision, over every finite input
+// (bench/trig_check.cc checks these):
+//
+//   fast_sincos   9.2e-8 (libm sinf: 3.3e-8); angles past
+//                 FAST_TRIG_RANGE go to libm, lane by lane
+//   fast_atan2    2.8e-7 rad (libm atan2f: 2.5e-7); 0 at the origin,
+//                 and PI, not -PI, for (-0, x < 0)
+//   wrap_angle    1.2e-7; angles past FAST_TRIG_RANGE go to libm. Below
+//                 it the result may overshoot [-PI, PI] by up to |a| * 1e-7
+//                 near half turns
+
+// minimax polynomials on [-PI/4, PI/4] and [0, tan(PI/8)], from Cephes
+const f32 SIN_P0 = -1.6666654611e-1f, SIN_P1 = 8.3321608736e-3f, SIN_P2 = -1.9515295891e-4f;
+const f32 COS_P0 = 4.166664568298827e-2f, COS_P1 = -1.388731625493765e-3f, COS_P2 = 2.443315711809948e-5f;
+const f32 ATAN_P0 = -3.33329491539e-1f, ATAN_P1 = 1.99777106478e-1f;
+const f32 ATAN_P2 = -1.38776856032e-1f, ATAN_P3 = 8.05374449538e-2f;
+
+// as round_nearest(f32)
+template <typename L>
+inline F32x<L> round_nearest(const F32x<L>& x)
+{
+  const F32x<L> magic = F32x<L>::splat(12582912.0f);
+  return (x + magic) - magic;
+}
+
+// as wrap_angle(f32)
+template <typename L>
+inline F32x<L> wrap_angle(const F32x<L>& a)
+{
+  typedef F32x<L> F;
+  const F k = round_nearest(a * F::splat(1 / TWO_PI));
+  const F w = ((a - k * F::splat(4 * PIO2_A)) - k * F::splat(4 * PIO2_B)) - k * F::splat(4 * PIO2_C);
+  const u32 far = (abs(a) > F::splat(FAST_TRIG_RANGE)).bits();
+  if (!far) {
+    return w;
+  }
+  f32 as[L::width], ws[L::width];
+  a.store(as);
+  w.store(ws);
+  for (u32 j = 0; j < L::width; j++) {
+    if (far >> j & 1) {
+      ws[j] = wrap_angle(as[j]);
+    }
+  }
+  return F::load(ws);
+}
+
+// sine and cosine in one pass: a is reduced to r in [-PI/4, PI/4] by a
+// multiple q of PI/2 (in three parts, Cody-Waite, so q * part is exact),
+// both minimax polynomials run on r, and q mod 4 swaps and negates them
+template <typename L>
+inline void fast_sincos(const F32x<L>& a, F32x<L>& s, F32x<L>& c)
+{
+  typedef F32x<L> F;
+  const F q = round_nearest(a * F::splat(0.63661977236758134f));    // 2 / PI
+  const F r = ((a - q * F::splat(PIO2_A)) - q * F::splat(PIO2_B)) - q * F::splat(PIO2_C);
+  const F r2 = r * r;
+  const F sr = r + r * r2 * (F::splat(SIN_P0) + r2 * (F::splat(SIN_P1) + r2 * F::splat(SIN_P2)));
+  const F cr = F::splat(1.0f) - F::splat(0.5f) * r2 +
+               r2 * r2 * (F::splat(COS_P0) + r2 * (F::splat(COS_P1) + r2 * F::splat(COS_P2)));
+
+  // q mod 4 as -2..2; quadrants 1 and 3 swap, sin is negative in 2 and
+  // 3, cos in 1 and 2
+  const F q4 = q - F::splat(4.0f) * round_nearest(q * F::splat(0.25f));
+  const F aq4 = abs(q4);
+  const Maskx<L> swap = (aq4 > F::splat(0.5f)) & (aq4 < F::splat(1.5f));
+  const Maskx<L> neg_s = (q4 < F::splat(-0.5f)) | (q4 > F::splat(1.5f));
+  const Maskx<L> neg_c = (q4 > F::splat(0.5f)) | (q4 < F::splat(-1.5f));
+  const F s1 = select(swap, cr, sr);
+  const F c1 = select(swap, sr, cr);
+  s = select(neg_s, -s1, s1);
+  c = select(neg_c, -c1, c1);
+
+  const u32 far = (abs(a) > F::splat(FAST_TRIG_RANGE)).bits();
+  if (far) {
+    f32 as[L::width], ss[L::width], cs[L::width];
+    a.store(as);
+    s.store(ss);
+    c.store(cs);
+    for (u32 j = 0; j < L::width; j++) {
+      if (far >> j & 1) {
+        fast_sincos(as[j], &ss[j], &cs[j]);
+      }
+    }
+    s = F::load(ss);
+    c = F::load(cs);
+  }
+}
+
+// atan of the smaller over the larger of |x| and |y|, in [0, PI/4], then
+// mirrored into the octant of (x, y). Past tan(PI/8) the ratio goes
+// through atan(t) = PI/4 + atan((t - 1) / (t + 1)). The ratio is taken
+// first: mn + mx overflows near FLT_MAX, and mx * tan(PI/8) rounds to
+// whole subnormals.
+template <typename L>
+inline F32x<L> fast_atan2(const F32x<L>& y, const F32x<L>& x)
+{
+  typedef F32x<L> F;
+  const F zero = F::splat(0.0f), one = F::splat(1.0f);
+  const F ax = abs(x), ay = abs(y);
+  const F mn = min(ax, ay), mx = max(ax, ay);
+  const F q = select(mx > zero, mn / mx, zero);
+  const Maskx<L> upper = q > F::splat(0.41421356237309503f);    // tan(PI/8)
+  const F t = select(upper, (q - one) / (q + one), q);
+  const F z = t * t;
+  F r = (((F::splat(ATAN_P3) * z + F::splat(ATAN_P2)) * z + F::splat(ATAN_P1)) * z +
+         F::splat(ATAN_P0)) * z * t + t;
+  r = r + select(upper, F::splat(PI / 4), zero);
+  r = select(ay > ax, F::splat(HALF_PI) - r, r);
+  r = select(x < zero, F::splat(PI) - r, r);
+  return select(y < zero, -r, r);
+}
+
+// each lane by its own angle
+template <typename L>
+inline Vec2x<L> rotate(const Vec2x<L>& v, const F32x<L>& angle)
+{
+  F32x<L> s, c;
+  fast_sincos(angle, s, c);
+  return rotate(v, s, c);
+}
+
+#if defined(__SSE2__)
+typedef F32x<Sse> F32x4;
+typedef Vec2x<Sse> Vec2x4;
+#endif
+#if defined(__AVX__)
+typedef F32x<Avx> F32x8;
+typedef Vec2x<Avx> Vec2x8;
+#endif
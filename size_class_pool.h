@@ -0,0 +1,202 @@
+// -*- c++ -*-
+#pragma once
+
+// General-purpose allocator for code that asks for bytes rather than
+// objects, i.e. s7 through s7_allocator:
+//
+//   static SizeClassPool s7_memory;
+//   s7 = s7_init_with_allocator(&s7_memory.allocator());
+//
+// Requests up to MAX_SMALL bytes are rounded up to a size class, and each
+// class is a SlotPool (misc.h), the untyped core of PoolAllocator. Larger
+// requests go to malloc. Every allocation starts with a 16 byte
+// header holding its class and requested size, so free() and realloc()
+// need no lookup and the bytes can be attributed.
+//
+// Blocks are kept until the pool is destroyed. Not thread-safe.
+
+#include "misc.h"
+#include "s7/s7.h"
+#include <stdlib.h>
+#include <string.h>
+
+class SizeClassPool
+{
+  struct Header
+  {
+    u32 size_class;    // LARGE if malloc'd
+    u32 unused;
+    u64 size;          // as requested
+  };
+  static_assert(sizeof(Header) == 16, "Header keeps the payload 16 byte aligned");
+
+  static const u32 LARGE = ~0u;
+  static const u32 MAX_SMALL = 1024;
+  static const u32 BLOCK_BYTES = 64 * 1024;    // at most, per class block
+
+  void* allocated(Header* h, u32 size_class, size_t bytes)
+  {
+    h->size_class = size_class;
+    h->size = bytes;
+    in_use += bytes;
+    peak = std::max(peak, in_use);
+    return h + 1;
+  }
+
+  std::vector<SlotPool> classes;    // of slots of payload plus header
+  std::vector<u8> class_of;         // by (bytes + 15) / 16
+  u64 in_use = 0;
+  u64 peak = 0;
+  u64 large = 0;    // bytes malloc'd for large requests, headers included
+  s7_allocator hooks;
+
+public:
+  // classes step by 16 bytes up to 128, then by a quarter of the power
+  // of two below (160, 192, 224, 256, 320, ...), so at most 25% is lost
+  // to rounding past 128
+  SizeClassPool()
+  {
+    for (u32 size = 16; size <= MAX_SMALL; ) {
+      const u32 slot = size + sizeof(Header);
+      classes.push_back(SlotPool(slot, BLOCK_BYTES / slot));
+      u32 pow2 = size;    // clear low bits down to the top one
+      while (pow2 & (pow2 - 1)) {
+        pow2 &= pow2 - 1;
+      }
+      size += size < 128 ? 16 : pow2 / 4;
+    }
+    class_of.resize(MAX_SMALL / 16 + 1);
+    for (u32 i = 0, c = 0; i < class_of.size(); i++) {
+      while (classes[c].slot_size() - sizeof(Header) < std::max(i * 16, 1u)) {
+        c++;
+      }
+      class_of[i] = c;
+    }
+
+    hooks.malloc = [](void* data, size_t bytes) {
+      return ((SizeClassPool*)data)->allocate(bytes);
+    };
+    hooks.calloc = [](void* data, size_t count, size_t size) {
+      return ((SizeClassPool*)data)->allocate_zeroed(count, size);
+    };
+    hooks.realloc = [](void* data, void* p, size_t bytes) {
+      return ((SizeClassPool*)data)->reallocate(p, bytes);
+    };
+    hooks.free = [](void* data, void* p) {
+      ((SizeClassPool*)data)->free(p);
+    };
+    hooks.data = this;
+  }
+
+  SizeClassPool(const SizeClassPool&) = delete;
+  SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+  // for s7_init_with_allocator; s7 copies it
+  const s7_allocator& allocator() const
+  {
+    return hooks;
+  }
+
+  void* allocate(size_t bytes)
+  {
+    if (bytes > MAX_SMALL) {
+      Header* h = (Header*)malloc(sizeof(Header) + bytes);
+      if (!h) {
+        return nullptr;
+      }
+      large += sizeof(Header) + bytes;
+      return allocated(h, LARGE, bytes);
+    }
+    const u32 i = class_of[(bytes + 15) >> 4];
+    return allocated((Header*)classes[i].allocate(), i, bytes);
+  }
+
+  void* allocate_zeroed(size_t count, size_t size)
+  {
+    if (size && count > SIZE_MAX / size) {
+      return nullptr;
+    }
+    const size_t bytes = count * size;
+    if (bytes > MAX_SMALL) {
+      Header* h = (Header*)calloc(1, sizeof(Header) + bytes);
+      if (!h) {
+        return nullptr;
+      }
+      large += sizeof(Header) + bytes;
+      return allocated(h, LARGE, bytes);
+    }
+    void* p = allocate(bytes);
+    memset(p, 0, bytes);
+    return p;
+  }
+
+  void* reallocate(void* p, size_t bytes)
+  {
+    if (!p) {
+      return allocate(bytes);
+    }
+    Header* h = (Header*)p - 1;
+    if (h->size_class == LARGE && bytes > MAX_SMALL) {
+      const u64 old = h->size;
+      h = (Header*)realloc(h, sizeof(Header) + bytes);
+      if (!h) {
+        return nullptr;
+      }
+      large = large - old + bytes;
+      in_use = in_use - old + bytes;
+      peak = std::max(peak, in_use);
+      h->size = bytes;
+      return h + 1;
+    }
+    if (h->size_class != LARGE &&
+        bytes <= classes[h->size_class].slot_size() - sizeof(Header)) {
+      in_use = in_use - h->size + bytes;    // still fits its slot
+      peak = std::max(peak, in_use);
+      h->size = bytes;
+      return p;
+    }
+    void* q = allocate(bytes);
+    if (!q) {
+      return nullptr;
+    }
+    memcpy(q, p, std::min<u64>(h->size, bytes));
+    free(p);
+    return q;
+  }
+
+  void free(void* p)
+  {
+    if (!p) {
+      return;
+    }
+    Header* h = (Header*)p - 1;
+    in_use -= h->size;
+    if (h->size_class == LARGE) {
+      large -= sizeof(Header) + h->size;
+      ::free(h);
+      return;
+    }
+    classes[h->size_class].free(h);
+  }
+
+  // bytes asked for and not yet freed
+  u64 bytes_in_use() const
+  {
+    return in_use;
+  }
+
+  u64 peak_bytes_in_use() const
+  {
+    return peak;
+  }
+
+  // what the pool holds from the system: its blocks plus large requests
+  u64 bytes_reserved() const
+  {
+    u64 bytes = large;
+    for (const SlotPool& c : classes) {
+      bytes += c.capacity() * c.slot_size();
+    }
+    return bytes;
+  }
+};
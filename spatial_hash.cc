@@ -0,0 +1,264 @@
+// -*- c++ -*-
+#include "spatial_hash.h"
+
+namespace
+{
+// ids into a caller's buffer, counting past its end
+struct Out
+{
+  i64* p;
+  u32 capacity;
+  u32 n;
+
+  void push(i64 id)
+  {
+    if (n < capacity) {
+      p[n] = id;
+    }
+    n++;
+  }
+
+  void push_pair(i64 a, i64 b)
+  {
+    if (2 * n + 2 <= capacity) {
+      p[2 * n] = a;
+      p[2 * n + 1] = b;
+    }
+    n++;
+  }
+};
+}
+
+SpatialHash::SpatialHash(f32 cell_size) : size(cell_size), inv_size(1 / cell_size), buckets(256)
+{
+}
+
+i32 SpatialHash::cell(f32 v) const
+{
+  // far off (or NaN) positions share the outermost cells
+  const f32 c = floorf(v * inv_size);
+  return c > -1e9f ? (c < 1e9f ? i32(c) : 1000000000) : -1000000000;
+}
+
+u32 SpatialHash::bucket(i32 cx, i32 cy) const
+{
+  u32 h = u32(cx) * 0x9e3779b1u ^ u32(cy) * 0x85ebca6bu;
+  h ^= h >> 15;
+  return h & (buckets.size() - 1);
+}
+
+void SpatialHash::link(const Item& item)
+{
+  const u32 b = bucket(item.cx, item.cy);
+  slots[item.id] = Slot{b, u32(buckets[b].size())};
+  buckets[b].push_back(item);
+}
+
+void SpatialHash::unlink(i32 id)
+{
+  const Slot s = slots[id];
+  std::vector<Item>& b = buckets[s.bucket];
+  b[s.at] = b.back();
+  slots[b[s.at].id].at = s.at;
+  b.pop_back();
+  slots[id].bucket = NONE;
+}
+
+void SpatialHash::place(i32 id, const Vec2& pos)
+{
+  const Slot s = slots[id];
+  Item& item = buckets[s.bucket][s.at];
+  item.pos = pos;
+  const i32 cx = cell(pos.x), cy = cell(pos.y);
+  if (cx != item.cx || cy != item.cy) {
+    Item moved = item;
+    moved.cx = cx;
+    moved.cy = cy;
+    unlink(id);
+    link(moved);
+  }
+}
+
+void SpatialHash::rehash(u32 n)
+{
+  std::vector<std::vector<Item>> old(n);
+  old.swap(buckets);
+  for (const std::vector<Item>& b : old) {
+    for (const Item& item : b) {
+      link(item);
+    }
+  }
+}
+
+void SpatialHash::insert(i32 id, const Vec2& pos, f32 radius)
+{
+  assert(id >= 0 && id < MAX_ID && !contains(id) && radius >= 0);
+  if (u32(id) >= slots.size()) {
+    slots.resize(std::max(u32(id) + 1, u32(slots.size() * 2)), Slot{NONE, 0});
+  }
+  if (++items > buckets.size()) {
+    rehash(buckets.size() * 2);
+  }
+  link(Item{pos, radius, id, cell(pos.x), cell(pos.y)});
+  max_radius = std::max(max_radius, radius);
+}
+
+bool SpatialHash::move(i32 id, const Vec2& pos)
+{
+  if (!contains(id)) {
+    return false;
+  }
+  place(id, pos);
+  return true;
+}
+
+void SpatialHash::move_all(const f32* xs, const f32* ys, u32 n)
+{
+  n = std::min(n, u32(slots.size()));
+  for (u32 id = 0; id < n; id++) {
+    if (slots[id].bucket != NONE) {
+      place(id, vec2(xs[id], ys[id]));
+    }
+  }
+}
+
+bool SpatialHash::remove(i32 id)
+{
+  if (!contains(id)) {
+    return false;
+  }
+  unlink(id);
+  items--;
+  return true;
+}
+
+void SpatialHash::clear()
+{
+  for (std::vector<Item>& b : buckets) {
+    for (const Item& item : b) {
+      slots[item.id].bucket = NONE;
+    }
+    b.clear();
+  }
+  items = 0;
+  max_radius = 0;
+}
+
+// f on every item centred in cells x0..x1 by y0..y1, or on every item
+// when there are fewer buckets than cells
+template <typename F>
+void SpatialHash::visit(i32 x0, i32 y0, i32 x1, i32 y1, F f) const
+{
+  if ((f32(x1) - x0 + 1) * (f32(y1) - y0 + 1) > buckets.size()) {
+    for (const std::vector<Item>& b : buckets) {
+      for (const Item& item : b) {
+        f(item);
+      }
+    }
+    return;
+  }
+  for (i32 cy = y0; cy <= y1; cy++) {
+    for (i32 cx = x0; cx <= x1; cx++) {
+      for (const Item& item : buckets[bucket(cx, cy)]) {
+        if (item.cx == cx && item.cy == cy) {
+          f(item);
+        }
+      }
+    }
+  }
+}
+
+u32 SpatialHash::query_circle(const Vec2& center, f32 radius, i64* out, u32 capacity) const
+{
+  Out o = {out, capacity, 0};
+  const f32 reach = radius + max_radius;
+  visit(cell(center.x - reach), cell(center.y - reach), cell(center.x + reach), cell(center.y + reach),
+        [&](const Item& e) {
+          if (length2(e.pos - center) <= sqr(radius + e.radius)) {
+            o.push(e.id);
+          }
+        });
+  return o.n;
+}
+
+u32 SpatialHash::query_rect(const Rect& r, i64* out, u32 capacity) const
+{
+  Out o = {out, capacity, 0};
+  const f32 x1 = r.x + r.w, y1 = r.y + r.h;
+  visit(cell(r.x - max_radius), cell(r.y - max_radius), cell(x1 + max_radius), cell(y1 + max_radius),
+        [&](const Item& e) {
+          // from the centre to the nearest point of the rect
+          const f32 dx = std::max(std::max(r.x - e.pos.x, e.pos.x - x1), 0.0f);
+          const f32 dy = std::max(std::max(r.y - e.pos.y, e.pos.y - y1), 0.0f);
+          if (dx * dx + dy * dy <= e.radius * e.radius) {
+            o.push(e.id);
+          }
+        });
+  return o.n;
+}
+
+u32 SpatialHash::pairs(i64* out, u32 capacity) const
+{
+  Out o = {out, capacity, 0};
+  const auto test = [&](const Item& a, const Item& b) {
+    if (length2(b.pos - a.pos) <= sqr(a.radius + b.radius)) {
+      o.push_pair(a.id, b.id);
+    }
+  };
+
+  // overlapping centres are at most 2 * max_radius apart, which is at
+  // most this many cells
+  const i32 reach = i32(ceilf(std::min(2 * max_radius * inv_size, 1e4f)));
+  if (f32(2 * reach + 1) * f32(reach + 1) > items) {
+    std::vector<Item> all;
+    for (const std::vector<Item>& b : buckets) {
+      all.insert(all.end(), b.begin(), b.end());
+    }
+    for (u32 i = 0; i < all.size(); i++) {
+      for (u32 j = i + 1; j < all.size(); j++) {
+        test(all[i], all[j]);
+      }
+    }
+    return o.n;
+  }
+
+  // each item against the later ones in its cell and every item in the
+  // half of its neighbourhood ahead of it (dy > 0, or dy = 0 and dx > 0),
+  // so every pair of cells is looked at from one side only
+  std::vector<std::pair<i32, i32>> ahead;
+  for (i32 dy = 0; dy <= reach; dy++) {
+    for (i32 dx = dy ? -reach : 1; dx <= reach; dx++) {
+      ahead.push_back(std::make_pair(dx, dy));
+    }
+  }
+  const auto scan = [&](const Item& a, i32 cx, i32 cy) {
+    for (const Item& c : buckets[bucket(cx, cy)]) {
+      if (c.cx == cx && c.cy == cy) {
+        test(a, c);
+      }
+    }
+  };
+  for (const std::vector<Item>& b : buckets) {
+    for (u32 i = 0; i < b.size(); i++) {
+      const Item& a = b[i];
+      for (u32 j = i + 1; j < b.size(); j++) {
+        if (b[j].cx == a.cx && b[j].cy == a.cy) {
+          test(a, b[j]);
+        }
+      }
+      if (reach == 1) {
+        // the usual case spelled out: four call sites whose branches
+        // predict separately run 30% faster than the loop
+        scan(a, a.cx + 1, a.cy);
+        scan(a, a.cx - 1, a.cy + 1);
+        scan(a, a.cx, a.cy + 1);
+        scan(a, a.cx + 1, a.cy + 1);
+      } else {
+        for (const std::pair<i32, i32>& d : ahead) {
+          scan(a, a.cx + d.first, a.cy + d.second);
+        }
+      }
+    }
+  }
+  return o.n;
+}
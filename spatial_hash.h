@@ -0,0 +1,95 @@
+// -*- c++ -*-
+#pragma once
+
+#include "misc.h"
+
+// Circles (points when the radius is 0) bucketed by the grid cell of their
+// centre, for neighbour and overlap queries that look at a few cells
+// instead of every object. Cells are hashed into a table of buckets that
+// doubles as objects are added, so the grid is unbounded and only
+// occupied cells cost memory; cells that share a bucket are told apart by
+// their coordinates.
+//
+// Objects are keyed by the caller's id, a small non-negative integer such
+// as an entity index. Queries write ids to out, at most capacity of them,
+// and return how many there were in total, so a caller whose buffer was
+// too small can grow it and ask again.
+//
+// A query reaches as far as the largest radius inserted since the last
+// clear(); a cell size around the diameter of a typical object keeps that
+// to the 3x3 cells around it.
+class SpatialHash
+{
+public:
+  static const i32 MAX_ID = 1 << 24;
+
+  explicit SpatialHash(f32 cell_size);
+
+  f32 cell_size() const
+  {
+    return size;
+  }
+
+  u32 count() const
+  {
+    return items;
+  }
+
+  bool contains(i32 id) const
+  {
+    return id >= 0 && u32(id) < slots.size() && slots[id].bucket != NONE;
+  }
+
+  // id in [0, MAX_ID) and not yet contained, radius >= 0
+  void insert(i32 id, const Vec2& pos, f32 radius);
+
+  // false if id is not contained
+  bool move(i32 id, const Vec2& pos);
+  bool remove(i32 id);
+  void clear();
+
+  // moves every object whose id is below n to (xs[id], ys[id])
+  void move_all(const f32* xs, const f32* ys, u32 n);
+
+  // the objects overlapping a circle or a rect
+  u32 query_circle(const Vec2& center, f32 radius, i64* out, u32 capacity) const;
+  u32 query_rect(const Rect& r, i64* out, u32 capacity) const;
+
+  // every overlapping pair once, as two ids; returns the number of pairs
+  u32 pairs(i64* out, u32 capacity) const;
+
+private:
+  static const u32 NONE = ~0u;
+
+  // stored in its bucket, so a query reads each bucket in one go
+  struct Item
+  {
+    Vec2 pos;
+    f32 radius;
+    i32 id;
+    i32 cx, cy;    // cell
+  };
+
+  struct Slot
+  {
+    u32 bucket;    // NONE if the id is absent
+    u32 at;
+  };
+
+  f32 size;
+  f32 inv_size;
+  f32 max_radius = 0;
+  u32 items = 0;
+  std::vector<Slot> slots;    // by id
+  std::vector<std::vector<Item>> buckets;
+
+  i32 cell(f32 v) const;
+  u32 bucket(i32 cx, i32 cy) const;
+  void link(const Item& item);
+  void unlink(i32 id);
+  void place(i32 id, const Vec2& pos);
+  void rehash(u32 n);
+
+  template <typename F>
+  void visit(i32 x0, i32 y0, i32 x1, i32 y1, F f) const;
+};
@@ -0,0 +1,96 @@
+// -*- c++ -*-
+#include "tween.h"
+
+#include "curve.h"
+
+const char* const ease_names[EASE_COUNT] = {"linear",    "cubic-in",     "cubic-out",  "cubic-in-out",
+                                            "back-in",   "back-out",     "elastic-in", "elastic-out",
+                                            "bounce-in", "bounce-out"};
+
+static const Curve elastic_in(ease_elastic_in);
+static const Curve elastic_out(ease_elastic_out);
+static const Curve bounce_in(ease_bounce_in);
+static const Curve bounce_out(ease_bounce_out);
+
+f32 ease(Ease e, f32 t)
+{
+  switch (e) {
+  case EASE_CUBIC_IN:
+    return ease_cubic_in(t);
+  case EASE_CUBIC_OUT:
+    return ease_cubic_out(t);
+  case EASE_CUBIC_IN_OUT:
+    return ease_cubic_in_out(t);
+  case EASE_BACK_IN:
+    return ease_back_in(t);
+  case EASE_BACK_OUT:
+    return ease_back_out(t);
+  case EASE_ELASTIC_IN:
+    return elastic_in.value(t);
+  case EASE_ELASTIC_OUT:
+    return elastic_out.value(t);
+  case EASE_BOUNCE_IN:
+    return bounce_in.value(t);
+  case EASE_BOUNCE_OUT:
+    return bounce_out.value(t);
+  default:
+    return ease_linear(t);
+  }
+}
+
+Handle<Tween> Tweens::add(const Tween& t, f32 duration, f32 delay)
+{
+  Tween n = t;
+  n.elapsed = -std::max(delay, 0.0f);
+  n.inv_duration = duration > 0 ? 1 / duration : 0;    // 0: done on the first update
+  return tweens.insert(n);
+}
+
+bool Tweens::kill(Handle<Tween> h, Tween* killed)
+{
+  Tween* t = tweens.get(h);
+  if (!t) {
+    return false;
+  }
+  *killed = *t;
+  return tweens.erase(h);
+}
+
+void Tweens::update(f32 dt, std::vector<Value>& values, std::vector<Tween>& finished)
+{
+  for (u32 i = 0; i < tweens.size();) {
+    Tween& t = tweens.begin()[i];
+    t.elapsed += dt;
+    if (t.elapsed < 0) {
+      i++;
+      continue;
+    }
+    if (!t.started) {
+      if (t.kind == Tween::VEC2) {
+        t.from = *(Vec2*)t.target;
+      } else if (t.kind == Tween::F64) {
+        t.from_f64 = *(f64*)t.target;
+      }
+      t.started = true;
+    }
+    const bool done = t.inv_duration == 0 || t.elapsed * t.inv_duration >= 1;
+    const f32 k = done ? 1 : ease(t.ease, t.elapsed * t.inv_duration);
+    switch (t.kind) {
+    case Tween::VEC2:
+      *(Vec2*)t.target = done ? t.to : lerp(t.from, t.to, k);
+      break;
+    case Tween::F64:
+      *(f64*)t.target = done ? t.to_f64 : t.from_f64 + (t.to_f64 - t.from_f64) * k;
+      break;
+    case Tween::CALL:
+      values.push_back(Value{tweens.handle_at(i), t.call, done ? t.to.x : lerp(t.from.x, t.to.x, k), done});
+      break;
+    }
+    if (done) {
+      finished.push_back(t);
+      tweens.erase(tweens.handle_at(i));    // the last one moves to i
+    } else {
+      i++;
+    }
+  }
+}
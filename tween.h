@@ -0,0 +1,112 @@
+// -*- c++ -*-
+#pragma once
+
+#include "misc.h"
+
+// Values animated natively: every tween in one SlotMap, advanced together
+// once per frame by Tweens::update. A tween writes a Vec2, an f64 (a
+// float-vector slot) or nothing (its owner is handed the value and calls
+// back into the script).
+
+enum Ease : u8
+{
+  EASE_LINEAR,
+  EASE_CUBIC_IN,
+  EASE_CUBIC_OUT,
+  EASE_CUBIC_IN_OUT,
+  EASE_BACK_IN,
+  EASE_BACK_OUT,
+  EASE_ELASTIC_IN,
+  EASE_ELASTIC_OUT,
+  EASE_BOUNCE_IN,
+  EASE_BOUNCE_OUT,
+  EASE_COUNT
+};
+
+extern const char* const ease_names[EASE_COUNT];    // "linear", "cubic-in", ...
+
+// elastic and bounce come from tables (curve.h), the rest is computed
+f32 ease(Ease e, f32 t);
+
+struct Tween
+{
+  enum Kind : u8
+  {
+    VEC2,    // target is a Vec2*
+    F64,     // target is an f64*, from and to in from_f64 and to_f64
+    CALL     // no target, the value is reported in .x
+  };
+
+  Kind kind;
+  Ease ease;
+  bool started;        // from has been read from the target
+  void* target;
+  union
+  {
+    Vec2 from;
+    f64 from_f64;
+  };
+  union
+  {
+    Vec2 to;
+    f64 to_f64;    // exactly what the target ends at, not rounded to f32
+  };
+  f32 elapsed;         // seconds since the delay ran out; negative before
+  f32 inv_duration;
+
+  // the owner's ids, e.g. gc-protected locations; -1 for none
+  i64 keep;        // whatever keeps target alive
+  i64 call;        // CALL: the callback
+  i64 on_done;
+};
+
+class Tweens
+{
+  SlotMap<Tween> tweens;
+
+public:
+  struct Value
+  {
+    Handle<Tween> tween;
+    i64 call;
+    f32 value;
+    bool last;    // the tween finished with this value
+  };
+
+  // starts after delay seconds; a VEC2 or F64 tween takes its from value
+  // from the target then, unless started is already set
+  Handle<Tween> add(const Tween& t, f32 duration, f32 delay);
+
+  // 0 if finished or killed
+  Tween* get(Handle<Tween> h)
+  {
+    return tweens.get(h);
+  }
+
+  // of a live tween, e.g. one returned by get()
+  Handle<Tween> handle(const Tween* t)
+  {
+    return tweens.handle_at(t - tweens.begin());
+  }
+
+  // no on_done; the caller releases the ids
+  bool kill(Handle<Tween> h, Tween* killed);
+
+  u32 size() const
+  {
+    return tweens.size();
+  }
+
+  // for define_handle_type
+  SlotMap<Tween>* map()
+  {
+    return &tweens;
+  }
+
+  // Advances every tween by dt seconds in one pass over the dense
+  // storage, writing VEC2 and F64 targets. Values of CALL tweens are
+  // appended to values, and tweens that reached their end (after writing
+  // it) are removed and appended to finished, both in storage order, for
+  // the owner to call back once the pass is over.
+  void update(f32 dt, std::vector<Value>& values, std::vector<Tween>& finished);
+};
@@ -0,0 +1,176 @@
+// -*- c++ -*-
+#include "vec2_buffer.h"
+
+#include "simd.h"
+
+template <typename L>
+static u32 fill_k(f32* xs, f32* ys, u32 i, u32 n, f32 x, f32 y)
+{
+  const Vec2x<L> v = Vec2x<L>::splat(vec2(x, y));
+  for (; i + L::width <= n; i += L::width) {
+    v.store(xs + i, ys + i);
+  }
+  return i;
+}
+
+void fill(Vec2Buffer& dst, const Vec2& v)
+{
+  u32 n = dst.size();
+  u32 i = fill_k<Wide>(dst.xs.data(), dst.ys.data(), 0, n, v.x, v.y);
+  fill_k<Scalar>(dst.xs.data(), dst.ys.data(), i, n, v.x, v.y);
+}
+
+template <typename L>
+static u32 madd_k(f32* xs, f32* ys, const f32* sx, const f32* sy, u32 i, u32 n, f32 s)
+{
+  const F32x<L> vs = F32x<L>::splat(s);
+  for (; i + L::width <= n; i += L::width) {
+    (Vec2x<L>::load(xs + i, ys + i) + Vec2x<L>::load(sx + i, sy + i) * vs).store(xs + i, ys + i);
+  }
+  return i;
+}
+
+void madd(Vec2Buffer& dst, const Vec2Buffer& src, f32 s)
+{
+  assert(dst.size() == src.size());
+  u32 n = dst.size();
+  u32 i = madd_k<Wide>(dst.xs.data(), dst.ys.data(), src.xs.data(), src.ys.data(), 0, n, s);
+  madd_k<Scalar>(dst.xs.data(), dst.ys.data(), src.xs.data(), src.ys.data(), i, n, s);
+}
+
+template <typename L>
+static u32 add_k(f32* xs, f32* ys, const f32* sx, const f32* sy, u32 i, u32 n)
+{
+  for (; i + L::width <= n; i += L::width) {
+    (Vec2x<L>::load(xs + i, ys + i) + Vec2x<L>::load(sx + i, sy + i)).store(xs + i, ys + i);
+  }
+  return i;
+}
+
+void add(Vec2Buffer& dst, const Vec2Buffer& src)
+{
+  assert(dst.size() == src.size());
+  u32 n = dst.size();
+  u32 i = add_k<Wide>(dst.xs.data(), dst.ys.data(), src.xs.data(), src.ys.data(), 0, n);
+  add_k<Scalar>(dst.xs.data(), dst.ys.data(), src.xs.data(), src.ys.data(), i, n);
+}
+
+template <typename L>
+static u32 scale_k(f32* xs, f32* ys, u32 i, u32 n, f32 s)
+{
+  const F32x<L> vs = F32x<L>::splat(s);
+  for (; i + L::width <= n; i += L::width) {
+    (Vec2x<L>::load(xs + i, ys + i) * vs).store(xs + i, ys + i);
+  }
+  return i;
+}
+
+void scale(Vec2Buffer& dst, f32 s)
+{
+  u32 n = dst.size();
+  u32 i = scale_k<Wide>(dst.xs.data(), dst.ys.data(), 0, n, s);
+  scale_k<Scalar>(dst.xs.data(), dst.ys.data(), i, n, s);
+}
+
+template <typename L>
+static u32 normalize_k(f32* xs, f32* ys, u32 i, u32 n)
+{
+  for (; i + L::width <= n; i += L::width) {
+    normalized(Vec2x<L>::load(xs + i, ys + i)).store(xs + i, ys + i);
+  }
+  return i;
+}
+
+void normalize(Vec2Buffer& dst)
+{
+  u32 n = dst.size();
+  u32 i = normalize_k<Wide>(dst.xs.data(), dst.ys.data(), 0, n);
+  normalize_k<Scalar>(dst.xs.data(), dst.ys.data(), i, n);
+}
+
+template <typename L>
+static u32 rotate_k(f32* xs, f32* ys, u32 i, u32 n, f32 s, f32 c)
+{
+  const F32x<L> vs = F32x<L>::splat(s), vc = F32x<L>::splat(c);
+  for (; i + L::width <= n; i += L::width) {
+    rotate(Vec2x<L>::load(xs + i, ys + i), vs, vc).store(xs + i, ys + i);
+  }
+  return i;
+}
+
+void rotate(Vec2Buffer& dst, f32 angle)
+{
+  f32 s, c;
+  sin_cos(angle, &s, &c);
+  u32 n = dst.size();
+  u32 i = rotate_k<Wide>(dst.xs.data(), dst.ys.data(), 0, n, s, c);
+  rotate_k<Scalar>(dst.xs.data(), dst.ys.data(), i, n, s, c);
+}
+
+template <typename L>
+static u32 lerp_k(f32* xs, f32* ys, const f32* sx, const f32* sy, u32 i, u32 n, f32 t)
+{
+  const F32x<L> vt = F32x<L>::splat(t);
+  for (; i + L::width <= n; i += L::width) {
+    lerp(Vec2x<L>::load(xs + i, ys + i), Vec2x<L>::load(sx + i, sy + i), vt).store(xs + i, ys + i);
+  }
+  return i;
+}
+
+void lerp(Vec2Buffer& dst, const Vec2Buffer& src, f32 t)
+{
+  assert(dst.size() == src.size());
+  u32 n = dst.size();
+  u32 i = lerp_k<Wide>(dst.xs.data(), dst.ys.data(), src.xs.data(), src.ys.data(), 0, n, t);
+  lerp_k<Scalar>(dst.xs.data(), dst.ys.data(), src.xs.data(), src.ys.data(), i, n, t);
+}
+
+template <typename L>
+static u32 clamp_k(f32* xs, f32* ys, u32 i, u32 n, const Vec2& min, const Vec2& max)
+{
+  const Vec2x<L> lo = Vec2x<L>::splat(min), hi = Vec2x<L>::splat(max);
+  for (; i + L::width <= n; i += L::width) {
+    clamp(Vec2x<L>::load(xs + i, ys + i), lo, hi).store(xs + i, ys + i);
+  }
+  return i;
+}
+
+void clamp(Vec2Buffer& dst, const Vec2& min, const Vec2& max)
+{
+  u32 n = dst.size();
+  u32 i = clamp_k<Wide>(dst.xs.data(), dst.ys.data(), 0, n, min, max);
+  clamp_k<Scalar>(dst.xs.data(), dst.ys.data(), i, n, min, max);
+}
+
+template <typename L>
+static u32 lengths_k(const f32* xs, const f32* ys, u32 i, u32 n, f64* out)
+{
+  for (; i + L::width <= n; i += L::width) {
+    length(Vec2x<L>::load(xs + i, ys + i)).store(out + i);
+  }
+  return i;
+}
+
+void lengths(const Vec2Buffer& src, f64* out)
+{
+  u32 n = src.size();
+  u32 i = lengths_k<Wide>(src.xs.data(), src.ys.data(), 0, n, out);
+  lengths_k<Scalar>(src.xs.data(), src.ys.data(), i, n, out);
+}
+
+template <typename L>
+static u32 dots_k(const f32* xs, const f32* ys, u32 i, u32 n, const Vec2& v, f64* out)
+{
+  const Vec2x<L> vv = Vec2x<L>::splat(v);
+  for (; i + L::width <= n; i += L::width) {
+    dot(Vec2x<L>::load(xs + i, ys + i), vv).store(out + i);
+  }
+  return i;
+}
+
+void dots(const Vec2Buffer& src, const Vec2& v, f64* out)
+{
+  u32 n = src.size();
+  u32 i = dots_k<Wide>(src.xs.data(), src.ys.data(), 0, n, v, out);
+  dots_k<Scalar>(src.xs.data(), src.ys.data(), i, n, v, out);
+}
@@ -0,0 +1,42 @@
+// -*- c++ -*-
+#pragma once
+
+#include "misc.h"
+
+// N vec2s stored as two contiguous arrays (structure of arrays), so the
+// bulk operations below run SIMD-wide: AVX when compiled with -mavx, SSE2
+// on any x86-64, scalar elsewhere.
+struct Vec2Buffer
+{
+  std::vector<f32> xs;
+  std::vector<f32> ys;
+
+  Vec2Buffer(u32 n) : xs(n, 0.0f), ys(n, 0.0f) {}
+
+  u32 size() const
+  {
+    return xs.size();
+  }
+
+  Vec2 get(u32 i) const
+  {
+    return vec2(xs[i], ys[i]);
+  }
+
+  void set(u32 i, const Vec2& v)
+  {
+    xs[i] = v.x;
+    ys[i] = v.y;
+  }
+};
+
+void fill(Vec2Buffer& dst, const Vec2& v);
+void add(Vec2Buffer& dst, const Vec2Buffer& src);              // dst += src
+void scale(Vec2Buffer& dst, f32 s);                            // dst *= s
+void madd(Vec2Buffer& dst, const Vec2Buffer& src, f32 s);      // dst += src * s
+void normalize(Vec2Buffer& dst);                               // zero vectors stay zero
+void rotate(Vec2Buffer& dst, f32 angle);
+void lerp(Vec2Buffer& dst, const Vec2Buffer& src, f32 t);      // dst = lerp(dst, src, t)
+void clamp(Vec2Buffer& dst, const Vec2& min, const Vec2& max);
+void lengths(const Vec2Buffer& src, f64* out);                 // out[i] = length(src[i])
+void dots(const Vec2Buffer& src, const Vec2& v, f64* out);     // out[i] = dot(src[i], v)